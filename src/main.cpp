@@ -2,11 +2,12 @@
 #include "utils/logger.h"
 #include "utils/system_utils.h"
 #include "utils/translations.h"
+#include "utils/metrics.h"
+#include "network/wifi_manager.h"
 #include <iostream>
 #include <exception>
 #include <memory>
 #include <csignal>
-#include <thread>
 #include <chrono>
 
 volatile std::sig_atomic_t shutdown_requested = 0;
@@ -18,13 +19,37 @@ int main(int argc, char** argv) {
     try {
         std::signal(SIGINT, signal_handler);
         std::signal(SIGTERM, signal_handler);
+        // Connect and wait loops log a lot; keep the disk and console off their threads
+        Logger::instance().set_async(true);
 
-        LOG(T("app_version"));
-        LOG(T("system_info") + SystemUtils::get_system_summary());
+        std::string lang;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--strongest-ap") WiFiManager::set_pin_strongest_ap(true);
+            else if (arg == "--lang" && i + 1 < argc) lang = argv[++i];
+            else if (arg.rfind("--lang=", 0) == 0) lang = arg.substr(7);
+            // Feed shell command lines to one long-lived /bin/sh instead of a /bin/sh -c
+            // each (no-op on Windows); argv commands such as nmcli and gsettings still
+            // spawn directly. Opt-in, so its savings can be compared in the stats below
+            else if (arg == "--persistent-shell") SystemUtils::set_persistent_shell(true);
+        }
+
+        // --lang picks any shipped lang/<code>.cat; otherwise follow the system
+        // locale when we have something for it, and stay in English when not
+        if (!lang.empty()) {
+            if (!Translations::instance().set_language(lang)) {
+                LOG_WARN("app", "No translations for {}, using English", {"lang", lang});
+            }
+        } else {
+            Translations::instance().set_language(Translations::system_language_code());
+        }
+
+        LOG_TR(LogLevel::Info, "app", "app_version");
+        LOG_TR(LogLevel::Info, "app", "system_info", {"system", SystemUtils::get_system_summary()});
 
         if (!SystemUtils::is_admin()) {
-            LOG(T("admin_warning"));
-            LOG(T("admin_warning_detail"));
+            LOG_TR(LogLevel::Warn, "app", "admin_warning");
+            LOG_TR(LogLevel::Warn, "app", "admin_warning_detail");
         }
 
         auto app = AppWindow::create();
@@ -61,13 +86,31 @@ int main(int argc, char** argv) {
             if (auto l = weak_logic.lock()) l->on_quit_app();
         });
 
-        logic->update_status();
+        // Signal handlers can't touch the UI; pick the flag up on the event loop,
+        // cancel whatever is running and leave
+        slint::Timer shutdown_watch;
+        shutdown_watch.start(slint::TimerMode::Repeated, std::chrono::milliseconds(100), [weak_logic]() {
+            if (!shutdown_requested) return;
+            if (auto l = weak_logic.lock()) l->cancel_work();
+            slint::quit_event_loop();
+        });
+
         app->run();
+        shutdown_watch.stop();
 
-        // Clear the logic reference before cleanup
+        // Cancel anything still running; destroying the logic joins its worker
+        logic->cancel_work();
         logic.reset();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto stats = SystemUtils::get_command_stats();
+        if (stats.commands_run > 0) {
+            LOG_INFO("app", "Command stats", {"commands_run", stats.commands_run},
+                     {"direct_spawns", stats.direct_spawns}, {"shell_commands", stats.shell_commands},
+                     {"shell_restarts", stats.shell_restarts});
+        }
+        SystemUtils::set_persistent_shell(false);
+
+        if (Metrics::instance().write_summary()) LOG("Latency summary written to logs/latency_summary.json");
 
         LOG("App closed.");
         return 0;
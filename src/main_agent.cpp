@@ -0,0 +1,231 @@
+/* Headless reconnect agent. Linux only.
+ *
+ *   AutoConnectAgent [--strongest-ap]
+ *
+ * Sleeps in epoll on rtnetlink link, address and default-route events, a
+ * timerfd and a signalfd; nothing is polled. When the WiFi link drops it waits
+ * a moment for NetworkManager's own autoconnect, then re-activates the saved
+ * profile with backoff until the link is back. Each reconnect runs on its own
+ * thread so the loop keeps listening: SIGINT/SIGTERM or the link coming back
+ * by itself cancel it. SIGINT/SIGTERM stop the agent.
+ * --strongest-ap pins each reconnect to the best ranked access point. */
+
+#include "utils/logger.h"
+#include "utils/cancellation.h"
+#include "utils/retry_scheduler.h"
+#include "network/link_monitor.h"
+#include "network/wifi_manager.h"
+#include "network/proxy_manager.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <iostream>
+
+// Zero disarms a timerfd, so the shortest arming is 1 ms
+static void arm_timer(int fd, std::chrono::milliseconds delay) {
+    long long ms = delay.count() > 0 ? delay.count() : 1;
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(ms / 1000);
+    spec.it_value.tv_nsec = static_cast<long>((ms % 1000) * 1000000);
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+static void disarm_timer(int fd) {
+    itimerspec spec{};
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+static bool watch(int epoll_fd, int fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+// WiFiManager::reconnect on a thread of its own, under a token the loop can
+// cancel. done_fd (an eventfd) becomes readable when it has returned.
+class ReconnectJob {
+public:
+    explicit ReconnectJob(int done_fd) : done_fd_(done_fd) {
+        thread_ = std::thread([this]() {
+            CancellationScope scope(token_);
+            result_ = WiFiManager::reconnect();
+            uint64_t one = 1;
+            while (write(done_fd_, &one, sizeof(one)) < 0 && errno == EINTR) {}
+        });
+    }
+    ~ReconnectJob() {
+        token_.cancel();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void cancel() { token_.cancel(); }
+    bool cancelled() const { return token_.cancelled(); }
+
+    // Joins the thread; call once done_fd has fired
+    WiFiResult finish() {
+        if (thread_.joinable()) thread_.join();
+        return result_;
+    }
+
+private:
+    int done_fd_;
+    CancellationToken token_;
+    WiFiResult result_{ false, "" };
+    std::thread thread_;
+};
+
+static std::string seconds_text(std::chrono::milliseconds delay) {
+    return std::to_string((delay.count() + 999) / 1000) + "s";
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--strongest-ap") {
+            WiFiManager::set_pin_strongest_ap(true);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--strongest-ap]\n";
+            return 2;
+        }
+    }
+
+    // Signals arrive on the signalfd instead of interrupting a reconnect
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+
+    // After the mask, so the log writer thread inherits it and leaves the signals to the signalfd
+    Logger::instance().set_async(true);
+
+    LinkMonitor monitor(true);
+    if (!monitor.available()) {
+        LOG("Agent: rtnetlink is not available");
+        return 1;
+    }
+
+    int signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    int done_fd = eventfd(0, EFD_CLOEXEC);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || timer_fd < 0 || done_fd < 0 || epoll_fd < 0 || !watch(epoll_fd, monitor.fd()) ||
+        !watch(epoll_fd, signal_fd) || !watch(epoll_fd, timer_fd) || !watch(epoll_fd, done_fd)) {
+        LOG(std::string("Agent: setup failed: ") + std::strerror(errno));
+        return 1;
+    }
+
+    // Set while recovering a dropped link; holds the backoff state between attempts
+    std::optional<RetryScheduler> backoff;
+    // The reconnect in flight, if any
+    std::optional<ReconnectJob> job;
+    bool connected = WiFiManager::is_connected();
+
+    // Give NetworkManager's own autoconnect the first go after a drop
+    const auto grace = RetryScheduler::policy(RetryPhase::AgentReconnect).initial;
+    if (connected) {
+        LOG("Agent: connected, watching the link");
+    } else {
+        LOG("Agent: not connected, reconnecting in " + seconds_text(grace) + " unless the link comes up");
+        backoff.emplace(RetryPhase::AgentReconnect);
+        arm_timer(timer_fd, grace);
+    }
+
+    bool running = true;
+    while (running) {
+        epoll_event events[4];
+        int count = epoll_wait(epoll_fd, events, 4, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            LOG(std::string("Agent: epoll_wait failed: ") + std::strerror(errno));
+            break;
+        }
+
+        bool link_changed = false;
+        bool timer_fired = false;
+        bool job_done = false;
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == signal_fd) {
+                signalfd_siginfo info;
+                if (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                    LOG_INFO("agent", "Caught signal, stopping", {"signal", info.ssi_signo});
+                }
+                running = false;
+            } else if (fd == timer_fd) {
+                uint64_t expirations;
+                if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)) timer_fired = true;
+            } else if (fd == done_fd) {
+                uint64_t finished;
+                if (read(done_fd, &finished, sizeof(finished)) == sizeof(finished)) job_done = true;
+            } else if (fd == monitor.fd()) {
+                if (monitor.process_events()) link_changed = true;
+            }
+        }
+        if (!running) break;
+
+        if (link_changed) {
+            bool now = WiFiManager::is_connected();
+            if (now && !connected) {
+                LOG("Agent: link is back");
+                backoff.reset();
+                disarm_timer(timer_fd);
+                // Whether it came back by itself or through the reconnect, stop waiting on that
+                if (job) job->cancel();
+            } else if (!now && connected) {
+                LOG("Agent: link lost, reconnecting in " + seconds_text(grace) + " unless it comes back");
+                backoff.emplace(RetryPhase::AgentReconnect);
+                arm_timer(timer_fd, grace);
+            }
+            connected = now;
+        }
+
+        if (job_done && job) {
+            bool cancelled = job->cancelled();
+            auto res = job->finish();
+            job.reset();
+            // Cancelled because the link came up counts as done too; it may have been our activation
+            if (res.success || connected) {
+                if (res.success) LOG("Agent: " + res.message);
+                connected = true;
+                backoff.reset();
+                if (!ProxyManager::is_configured()) {
+                    LOG("Agent: " + ProxyManager::apply_settings().message);
+                }
+            } else if (!cancelled && backoff) {
+                auto delay = backoff->next_delay();
+                LOG("Agent: reconnect failed (" + res.message + "), retrying in " + seconds_text(delay));
+                arm_timer(timer_fd, delay);
+            }
+        }
+
+        // A missed event can leave connected stale; never bounce a link autoconnect already restored
+        if (timer_fired && backoff && !connected && WiFiManager::is_connected()) {
+            LOG("Agent: link is back");
+            connected = true;
+            backoff.reset();
+        }
+
+        if (timer_fired && backoff && !connected && !job) job.emplace(done_fd);
+    }
+
+    if (job) LOG("Agent: cancelling the reconnect in progress");
+    job.reset();
+    close(epoll_fd);
+    close(done_fd);
+    close(timer_fd);
+    close(signal_fd);
+    LOG("Agent: stopped");
+    return 0;
+}
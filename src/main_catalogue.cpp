@@ -0,0 +1,128 @@
+/* Builds translation catalogue files for Translations (see TranslationCatalogue).
+ *
+ *   AutoConnectCatalogue template          > zu.tsv
+ *   AutoConnectCatalogue build zu.tsv lang/zu.cat
+ *
+ * template prints every built-in key with its English text as "key<TAB>text"
+ * lines for translators to fill in. build turns such a file into a catalogue;
+ * blank lines and # comments are skipped, and \n, \t and \\ in the text are
+ * unescaped. A text must keep as many {} placeholders as the English one, or
+ * nothing is written. Ship the result as lang/<code>.cat next to the app and
+ * pick it with --lang <code> (or a matching system locale). */
+
+#include "utils/translation_table.h"
+#include "utils/translation_catalogue.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <set>
+#include <map>
+
+static std::string unescape(std::string_view text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char next = text[++i];
+            if (next == 'n') out += '\n';
+            else if (next == 't') out += '\t';
+            else out += next;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+static std::string escape(std::string_view text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '\n') out += "\\n";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\\') out += "\\\\";
+        else out += c;
+    }
+    return out;
+}
+
+static size_t count_placeholders(std::string_view text) {
+    size_t count = 0;
+    for (size_t pos = text.find("{}"); pos != std::string_view::npos; pos = text.find("{}", pos + 2)) count++;
+    return count;
+}
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " template\n"
+              << "       " << argv0 << " build <input.tsv> <output.cat>\n";
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+
+    if (command == "template" && argc == 2) {
+        for (const auto& entry : TRANSLATION_TABLE) {
+            std::cout << entry.key << '\t' << escape(entry.text[0]) << '\n';
+        }
+        return 0;
+    }
+    if (command != "build" || argc != 4) return usage(argv[0]);
+
+    std::ifstream in(argv[2]);
+    if (!in) {
+        std::cerr << "Cannot read " << argv[2] << "\n";
+        return 1;
+    }
+
+    // Key -> English text, whose "{}" count each translation has to match
+    std::map<std::string_view, std::string_view> known;
+    for (const auto& entry : TRANSLATION_TABLE) known.emplace(entry.key, entry.text[0]);
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    std::set<std::string> seen;
+    std::string line;
+    int line_no = 0;
+    int errors = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            std::cerr << "Line " << line_no << ": expected key<TAB>text\n";
+            continue;
+        }
+        std::string key = line.substr(0, tab);
+        std::string text = unescape(std::string_view(line).substr(tab + 1));
+        auto english = known.find(key);
+        if (english == known.end()) {
+            std::cerr << "Line " << line_no << ": unknown key " << key << " (ignored by the app)\n";
+        } else {
+            seen.insert(key);
+            // The logger fills each {} with the next field; a lost or extra one shifts them all
+            size_t expected = count_placeholders(english->second);
+            size_t found = count_placeholders(text);
+            if (found != expected) {
+                std::cerr << "Line " << line_no << ": " << key << " has " << found << " {} placeholders, English has "
+                          << expected << "\n";
+                errors++;
+            }
+        }
+        entries.emplace_back(key, std::move(text));
+    }
+    if (errors > 0) {
+        std::cerr << errors << " placeholder mismatches, " << argv[3] << " not written\n";
+        return 1;
+    }
+
+    size_t missing = 0;
+    for (const auto& [key, english] : known) missing += seen.count(std::string(key)) ? 0 : 1;
+
+    if (!TranslationCatalogue::write(argv[3], std::move(entries))) {
+        std::cerr << "Cannot write " << argv[3] << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << argv[3] << " (" << seen.size() << " keys, " << missing
+              << " left to the built-in text)\n";
+    return 0;
+}
@@ -0,0 +1,84 @@
+/* Headless keyfile baker for lab images. No UI, no nmcli, no NetworkManager needed.
+ *
+ *   AutoConnectKeyfiles [--method peap|ttls|peap-md5] [--password] [list]
+ *
+ * Reads "target_root<TAB>student_id<TAB>birthday" lines from list (or stdin) and
+ * writes one .nmconnection per root. With --password the third column is taken
+ * as-is instead of as a birthday. Blank lines and # comments are skipped. */
+
+#include "utils/logger.h"
+#include "network/wifi_manager.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+
+int main(int argc, char** argv) {
+    std::string method = "peap";
+    std::string list_path;
+    bool custom_password = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--method" && i + 1 < argc) method = argv[++i];
+        else if (arg == "--password") custom_password = true;
+        else if (!arg.empty() && arg[0] != '-') list_path = arg;
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--method peap|ttls|peap-md5] [--password] [list]\n";
+            return 2;
+        }
+    }
+
+    std::ifstream file;
+    if (!list_path.empty()) {
+        file.open(list_path);
+        if (!file) {
+            LOG("Cannot open " + list_path);
+            return 1;
+        }
+    }
+    std::istream& in = list_path.empty() ? std::cin : file;
+
+    auto started = std::chrono::steady_clock::now();
+    unsigned long written = 0, unchanged = 0, failed = 0, line_no = 0;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string root, sid, secret;
+        if (!std::getline(fields, root, '\t') || !std::getline(fields, sid, '\t') || !std::getline(fields, secret) ||
+            root.empty() || sid.empty() || secret.empty()) {
+            LOG("Line " + std::to_string(line_no) + ": expected root, student id and secret separated by tabs");
+            failed++;
+            continue;
+        }
+
+        WiFiCredentials creds;
+        creds.student_id = sid;
+        if (custom_password) creds.custom_password = secret;
+        else creds.birthday = secret;
+
+        // Only failures are logged; a bake can be thousands of lines
+        bool did_write = false;
+        auto res = WiFiManager::write_linux_keyfile(method, creds, root, &did_write);
+        if (!res.success) {
+            LOG("Line " + std::to_string(line_no) + ": " + res.message);
+            failed++;
+        } else if (did_write) {
+            written++;
+        } else {
+            unchanged++;
+        }
+    }
+
+    long elapsed_ms = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count());
+    LOG("Keyfiles: " + std::to_string(written) + " written, " + std::to_string(unchanged) + " unchanged, " +
+        std::to_string(failed) + " failed in " + std::to_string(elapsed_ms) + " ms");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#include "connection_history.h"
+#include "../utils/cancellation.h"
+#include "../utils/retry_scheduler.h"
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+
+static const std::string HISTORY_DIR = "data";
+static const std::string HISTORY_FILE = "data/connection_history.tsv";
+static const std::string FINGERPRINT_FILE = "data/profile_fingerprints.tsv";
+
+// Replaces path with the contents atomically (temp file + rename)
+static void write_file_atomic(const std::string& path, const std::string& contents) {
+    std::error_code ec;
+    if (!std::filesystem::exists(HISTORY_DIR, ec)) std::filesystem::create_directory(HISTORY_DIR, ec);
+
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << contents;
+        if (!out) return;
+    }
+    std::filesystem::rename(temp, path, ec);
+}
+
+ConnectionHistory& ConnectionHistory::instance() {
+    static ConnectionHistory instance;
+    return instance;
+}
+
+ConnectionHistory::ConnectionHistory() {
+    load();
+}
+
+void ConnectionHistory::load() {
+    std::ifstream in(HISTORY_FILE);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Entry e{ "", "", "", 0, 0, 0, 0 };
+        std::string successes, failures, duration, last_success;
+        if (!std::getline(fields, e.ssid, '\t') || !std::getline(fields, e.interface_name, '\t') ||
+            !std::getline(fields, e.method, '\t') || !std::getline(fields, successes, '\t') ||
+            !std::getline(fields, failures, '\t') || !std::getline(fields, duration, '\t') ||
+            !std::getline(fields, last_success)) {
+            continue;
+        }
+        try {
+            e.successes = std::stoi(successes);
+            e.failures = std::stoi(failures);
+            e.last_duration_ms = std::stol(duration);
+            e.last_success = std::stoll(last_success);
+        } catch (...) {
+            continue;
+        }
+        entries_.push_back(std::move(e));
+    }
+
+    std::ifstream fp_in(FINGERPRINT_FILE);
+    while (std::getline(fp_in, line)) {
+        size_t tab = line.find('\t');
+        if (tab != std::string::npos) fingerprints_.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+    }
+}
+
+void ConnectionHistory::save() const {
+    std::ostringstream out;
+    for (const auto& e : entries_) {
+        out << e.ssid << '\t' << e.interface_name << '\t' << e.method << '\t' << e.successes << '\t'
+            << e.failures << '\t' << e.last_duration_ms << '\t' << e.last_success << '\n';
+    }
+    write_file_atomic(HISTORY_FILE, out.str());
+}
+
+void ConnectionHistory::save_fingerprints() const {
+    std::string out;
+    for (const auto& [ssid, fp] : fingerprints_) out += ssid + '\t' + fp + '\n';
+    write_file_atomic(FINGERPRINT_FILE, out);
+}
+
+void ConnectionHistory::record(std::string_view ssid, std::string_view interface_name, std::string_view method,
+                               bool success, long duration_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) {
+        return e.ssid == ssid && e.interface_name == interface_name && e.method == method;
+    });
+    if (it == entries_.end()) {
+        entries_.push_back({ std::string(ssid), std::string(interface_name), std::string(method), 0, 0, 0, 0 });
+        it = entries_.end() - 1;
+    }
+
+    if (success) {
+        it->successes++;
+        it->last_duration_ms = duration_ms;
+        it->last_success = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    } else {
+        it->failures++;
+    }
+    save();
+}
+
+bool ConnectionHistory::record_failure(std::string_view ssid, std::string_view interface_name, std::string_view method,
+                                       long duration_ms, const Deadline& budget) {
+    if (budget.expired() || CancellationToken::current().cancelled()) return false;
+    record(ssid, interface_name, method, false, duration_ms);
+    return true;
+}
+
+std::vector<std::string> ConnectionHistory::order_methods(std::string_view ssid, std::string_view interface_name,
+                                                          const std::vector<std::string>& defaults) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    bool have_interface = std::any_of(entries_.begin(), entries_.end(), [&](const Entry& e) {
+        return e.ssid == ssid && e.interface_name == interface_name;
+    });
+
+    // Fold the relevant entries into one score per method
+    struct Score {
+        long long last_success = 0;
+        int successes = 0;
+        int failures = 0;
+    };
+    std::vector<Score> scores(defaults.size());
+    for (const auto& e : entries_) {
+        if (e.ssid != ssid) continue;
+        if (have_interface && e.interface_name != interface_name) continue;
+        auto pos = std::find(defaults.begin(), defaults.end(), e.method);
+        if (pos == defaults.end()) continue;
+        auto& s = scores[static_cast<size_t>(pos - defaults.begin())];
+        s.last_success = std::max(s.last_success, e.last_success);
+        s.successes += e.successes;
+        s.failures += e.failures;
+    }
+
+    auto rank = [](const Score& s) {
+        if (s.successes > 0) return 0;
+        if (s.failures == 0) return 1;
+        return 2;
+    };
+
+    std::vector<size_t> order(defaults.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        int ra = rank(scores[a]);
+        int rb = rank(scores[b]);
+        if (ra != rb) return ra < rb;
+        if (ra == 0) return scores[a].last_success > scores[b].last_success;
+        return false;
+    });
+
+    std::vector<std::string> ordered;
+    for (size_t i : order) ordered.push_back(defaults[i]);
+    return ordered;
+}
+
+std::string ConnectionHistory::applied_fingerprint(std::string_view ssid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [s, fp] : fingerprints_) {
+        if (s == ssid) return fp;
+    }
+    return "";
+}
+
+void ConnectionHistory::set_applied_fingerprint(std::string_view ssid, std::string_view fingerprint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(fingerprints_.begin(), fingerprints_.end(), [&](const auto& p) { return p.first == ssid; });
+    if (it != fingerprints_.end()) {
+        if (it->second == fingerprint) return;
+        it->second = std::string(fingerprint);
+    } else {
+        fingerprints_.emplace_back(std::string(ssid), std::string(fingerprint));
+    }
+    save_fingerprints();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <string_view>
+
+class Deadline;
+
+// Remembers which EAP method worked for an SSID on a given interface, and how
+// long it took, so the next connect can try that method first. Stored as a
+// small tab separated file next to the logs.
+class ConnectionHistory {
+public:
+    static ConnectionHistory& instance();
+
+    void record(std::string_view ssid, std::string_view interface_name, std::string_view method,
+                bool success, long duration_ms);
+
+    // record(..., false, ...) for an attempt that ran its course. One cut short
+    // by a cancel or by the connect's budget running out says nothing about the
+    // method, so it is dropped; returns whether it was recorded.
+    bool record_failure(std::string_view ssid, std::string_view interface_name, std::string_view method,
+                        long duration_ms, const Deadline& budget);
+
+    // Returns defaults reordered: methods that succeeded (most recent first),
+    // then untried ones, then ones that have only ever failed. Entries for
+    // interface_name win; if there are none, any interface for the SSID counts.
+    std::vector<std::string> order_methods(std::string_view ssid, std::string_view interface_name,
+                                           const std::vector<std::string>& defaults);
+
+    // Fingerprint of the profile we last wrote for ssid, empty if unknown. Used
+    // where the stored profile can't be read back in full (Windows EAP data).
+    std::string applied_fingerprint(std::string_view ssid);
+    void set_applied_fingerprint(std::string_view ssid, std::string_view fingerprint);
+
+private:
+    ConnectionHistory();
+
+    struct Entry {
+        std::string ssid;
+        std::string interface_name;
+        std::string method;
+        int successes;
+        int failures;
+        long last_duration_ms;
+        long long last_success;   // unix seconds, 0 if never
+    };
+
+    std::mutex mutex_;
+    std::vector<Entry> entries_;
+    std::vector<std::pair<std::string, std::string>> fingerprints_;
+
+    void load();
+    void save() const;
+    void save_fingerprints() const;
+};
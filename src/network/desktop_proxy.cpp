@@ -0,0 +1,214 @@
+#include "desktop_proxy.h"
+#include "../utils/system_utils.h"
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstdlib>
+
+namespace {
+
+    const std::string DCONF_PROXY_DIR = "/system/proxy/";
+    const std::string GSETTINGS_PROXY_SCHEMA = "org.gnome.system.proxy";
+
+    std::string trim(std::string_view s) {
+        size_t start = s.find_first_not_of(" \t\r\n");
+        if (start == std::string_view::npos) return "";
+        size_t end = s.find_last_not_of(" \t\r\n");
+        return std::string(s.substr(start, end - start + 1));
+    }
+
+    // Keyfile as printed by `dconf dump`: [group] headers followed by key=value lines.
+    std::map<std::pair<std::string, std::string>, std::string> parse_dconf_dump(const std::string& text) {
+        std::map<std::pair<std::string, std::string>, std::string> values;
+        std::istringstream in(text);
+        std::string line;
+        std::string group;
+        while (std::getline(in, line)) {
+            std::string t = trim(line);
+            if (t.empty() || t[0] == '#') continue;
+            if (t.front() == '[' && t.back() == ']') {
+                group = t.substr(1, t.size() - 2);
+                if (group == "/") group.clear();
+                continue;
+            }
+            size_t eq = t.find('=');
+            if (eq == std::string::npos) continue;
+            values[{ group, trim(t.substr(0, eq)) }] = trim(t.substr(eq + 1));
+        }
+        return values;
+    }
+
+    std::filesystem::path kioslaverc_path() {
+        if (const char* xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+            return std::filesystem::path(xdg) / "kioslaverc";
+        }
+        if (const char* home = std::getenv("HOME"); home && *home) {
+            return std::filesystem::path(home) / ".config" / "kioslaverc";
+        }
+        return {};
+    }
+
+    bool running_kde() {
+        const char* desktop = std::getenv("XDG_CURRENT_DESKTOP");
+        return desktop && std::string(desktop).find("KDE") != std::string::npos;
+    }
+
+}
+
+DesktopProxyBatch::DesktopProxyBatch(DesktopBackend backend) : backend_(backend) {
+}
+
+void DesktopProxyBatch::set(std::string_view group, std::string_view key, std::string_view value) {
+    for (auto& e : entries_) {
+        if (e.group == group && e.key == key) {
+            e.value = std::string(value);
+            return;
+        }
+    }
+    entries_.push_back({ std::string(group), std::string(key), std::string(value) });
+}
+
+DesktopProxyResult DesktopProxyBatch::apply() {
+    if (entries_.empty()) return { true, 0, 0, "Nothing to apply" };
+    return backend_ == DesktopBackend::GNOME ? apply_gnome() : apply_kde();
+}
+
+std::string DesktopProxyBatch::gvariant_string(std::string_view value) {
+    std::string out = "'";
+    for (char c : value) {
+        if (c == '\'' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '\'';
+    return out;
+}
+
+DesktopProxyResult DesktopProxyBatch::apply_gnome() {
+    auto dump = SystemUtils::run_command({ "dconf", "dump", DCONF_PROXY_DIR }, 10);
+
+    if (!dump.success) {
+        // No dconf binary (or no session bus for it): one gsettings call per key, like before
+        int written = 0;
+        for (const auto& e : entries_) {
+            std::string schema = e.group.empty() ? GSETTINGS_PROXY_SCHEMA : GSETTINGS_PROXY_SCHEMA + "." + e.group;
+            if (SystemUtils::run_command({ "gsettings", "set", schema, e.key, e.value }, 10).success) written++;
+        }
+        bool ok = written == static_cast<int>(entries_.size());
+        return { ok, written, 0, ok ? "GNOME proxy set via gsettings" : "gsettings failed for some keys" };
+    }
+
+    auto current = parse_dconf_dump(dump.stdout_output);
+
+    // Group the changed keys by dconf directory for the load fragment
+    std::map<std::string, std::string> sections;
+    int skipped = 0;
+    for (const auto& e : entries_) {
+        auto it = current.find({ e.group, e.key });
+        if (it != current.end() && it->second == e.value) {
+            skipped++;
+            continue;
+        }
+        sections[e.group] += e.key + "=" + e.value + "\n";
+    }
+
+    if (sections.empty()) return { true, 0, skipped, "GNOME proxy already up to date" };
+
+    std::string fragment;
+    int written = 0;
+    for (const auto& [group, body] : sections) {
+        fragment += "[" + (group.empty() ? std::string("/") : group) + "]\n" + body + "\n";
+        for (char c : body) if (c == '\n') written++;
+    }
+
+    auto load = SystemUtils::run_command_with_input({ "dconf", "load", DCONF_PROXY_DIR }, fragment, 10);
+    if (!load.success) return { false, 0, skipped, "dconf load failed: " + load.error_text() };
+
+    return { true, written, skipped, "GNOME proxy updated" };
+}
+
+DesktopProxyResult DesktopProxyBatch::apply_kde() {
+    auto path = kioslaverc_path();
+    if (path.empty()) return { false, 0, 0, "No HOME for kioslaverc" };
+
+    // Don't leave a kioslaverc behind on machines that never ran Plasma
+    if (!std::filesystem::exists(path) && !running_kde()) return { true, 0, 0, "KDE not in use" };
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) lines.push_back(line);
+    }
+
+    int written = 0;
+    int skipped = 0;
+    for (const auto& e : entries_) {
+        const std::string header = "[" + e.group + "]";
+        const std::string wanted = e.key + "=" + e.value;
+
+        size_t group_start = lines.size();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (trim(lines[i]) == header) {
+                group_start = i;
+                break;
+            }
+        }
+
+        if (group_start == lines.size()) {
+            if (!lines.empty() && !trim(lines.back()).empty()) lines.push_back("");
+            lines.push_back(header);
+            lines.push_back(wanted);
+            written++;
+            continue;
+        }
+
+        size_t group_end = group_start + 1;
+        while (group_end < lines.size() && trim(lines[group_end]).rfind('[', 0) != 0) group_end++;
+
+        size_t found = group_end;
+        for (size_t i = group_start + 1; i < group_end; ++i) {
+            std::string t = trim(lines[i]);
+            size_t eq = t.find('=');
+            if (eq != std::string::npos && trim(t.substr(0, eq)) == e.key) {
+                found = i;
+                break;
+            }
+        }
+
+        if (found != group_end) {
+            if (trim(lines[found]) == wanted) {
+                skipped++;
+                continue;
+            }
+            lines[found] = wanted;
+        } else {
+            // Insert after the last non-blank line of the group
+            size_t insert_at = group_end;
+            while (insert_at > group_start + 1 && trim(lines[insert_at - 1]).empty()) insert_at--;
+            lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(insert_at), wanted);
+        }
+        written++;
+    }
+
+    if (written == 0) return { true, 0, skipped, "KDE proxy already up to date" };
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto temp = path;
+    temp += ".autoconnect.tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        for (const auto& l : lines) out << l << "\n";
+        if (!out) return { false, 0, skipped, "Failed to write " + temp.string() };
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return { false, 0, skipped, "Failed to replace " + path.string() };
+    }
+
+    return { true, written, skipped, "KDE proxy updated" };
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <string_view>
+
+enum class DesktopBackend {
+    GNOME,
+    KDE
+};
+
+struct DesktopProxyResult {
+    bool success;
+    int written;
+    int skipped;
+    std::string message;
+};
+
+// Collects proxy key changes for one desktop backend and applies them in a
+// single operation, skipping keys that already hold the wanted value.
+//
+// GNOME: group is the dconf directory under /system/proxy/ ("" for the root,
+// "http" for org.gnome.system.proxy.http) and value is GVariant text, e.g.
+// "'auto'" or "3128". One `dconf dump` to compare, one `dconf load` if
+// anything changed. Falls back to gsettings per key if dconf is missing.
+//
+// KDE: group is the kioslaverc group and value is written verbatim. The file
+// is edited in place (write to temp + rename); no kwriteconfig5 processes.
+class DesktopProxyBatch {
+public:
+    explicit DesktopProxyBatch(DesktopBackend backend);
+
+    void set(std::string_view group, std::string_view key, std::string_view value);
+    DesktopProxyResult apply();
+
+    // Quotes a string as GVariant text: 'value' with ' and \ escaped.
+    static std::string gvariant_string(std::string_view value);
+
+private:
+    struct Entry {
+        std::string group;
+        std::string key;
+        std::string value;
+    };
+
+    DesktopBackend backend_;
+    std::vector<Entry> entries_;
+
+    DesktopProxyResult apply_gnome();
+    DesktopProxyResult apply_kde();
+};
@@ -1,4 +1,6 @@
 #include "device_registry.h"
+#include "../utils/metrics.h"
+#include "../utils/cancellation.h"
 #include <cpr/cpr.h>
 #include <iostream>
 
@@ -7,6 +9,9 @@ RegistrationResult DeviceRegistry::try_registration_url(
     std::string_view sid,
     std::string_view pwd) {
 
+    ScopedSpan span("portal.post");
+    // curl calls this while the request is in flight; false aborts it
+    auto token = CancellationToken::current();
     auto res = cpr::Post( // I mean, to be honest, this is rather self explanator. In pythgon we go requests_object.post("some stff here")
         cpr::Url{std::string(url)},
         cpr::Payload{
@@ -14,8 +19,12 @@ RegistrationResult DeviceRegistry::try_registration_url(
             {"pass", std::string(pwd)},
             {"submit", "ACCEPT"}
         },
-        cpr::Timeout{10000}
+        cpr::Timeout{10000},
+        // netreg sits on the campus LAN; an empty proxy makes curl ignore http_proxy
+        cpr::Proxies{ {"http", ""}, {"https", ""} },
+        cpr::ProgressCallback{ [token](auto...) { return !token.cancelled(); } }
     );
+    span.finish();
 
     if (res.status_code == 200 || res.status_code == 302) {
         //TODO: test this to make sure it works to the same degree as py
@@ -0,0 +1,233 @@
+#include "link_monitor.h"
+#include "../utils/cancellation.h"
+#include <filesystem>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/if.h>
+#include <linux/if_addr.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <cerrno>
+#include <algorithm>
+#endif
+
+#if defined(__linux__)
+
+namespace {
+
+    bool is_wireless(const std::string& name) {
+        std::error_code ec;
+        auto base = std::filesystem::path("/sys/class/net") / name;
+        return std::filesystem::exists(base / "wireless", ec) || std::filesystem::exists(base / "phy80211", ec);
+    }
+
+}
+
+LinkMonitor::LinkMonitor(bool watch_routes)
+    : socket_(NETLINK_ROUTE, RTMGRP_LINK | RTMGRP_IPV4_IFADDR | (watch_routes ? RTMGRP_IPV4_ROUTE : 0)) {
+    seed();
+}
+
+bool LinkMonitor::available() const {
+    return socket_.valid() && seeded_;
+}
+
+int LinkMonitor::fd() const {
+    return socket_.fd();
+}
+
+void LinkMonitor::seed() {
+    if (!socket_.valid()) return;
+
+    bool changed = false;
+    auto handler = [this, &changed](const nlmsghdr* msg) { changed = handle_message(msg) || changed; };
+
+    ifinfomsg link_req{};
+    link_req.ifi_family = AF_UNSPEC;
+    if (!socket_.request(RTM_GETLINK, NLM_F_DUMP, &link_req, sizeof(link_req), handler)) return;
+
+    ifaddrmsg addr_req{};
+    addr_req.ifa_family = AF_INET;
+    if (!socket_.request(RTM_GETADDR, NLM_F_DUMP, &addr_req, sizeof(addr_req), handler)) return;
+
+    seeded_ = true;
+}
+
+bool LinkMonitor::handle_message(const nlmsghdr* msg) {
+    switch (msg->nlmsg_type) {
+        case RTM_NEWLINK:
+        case RTM_DELLINK: {
+            const auto* info = static_cast<const ifinfomsg*>(NLMSG_DATA(msg));
+            if (msg->nlmsg_type == RTM_DELLINK) {
+                addresses_.erase(info->ifi_index);
+                return links_.erase(info->ifi_index) > 0;
+            }
+
+            std::string name;
+            int operstate = IF_OPER_UNKNOWN;
+            for_each_attr(IFLA_RTA(info), IFLA_PAYLOAD(msg), [&](uint16_t type, const char* data, size_t len) {
+                if (type == IFLA_IFNAME && len > 0) name.assign(data, strnlen(data, len));
+                else if (type == IFLA_OPERSTATE && len >= 1) operstate = static_cast<unsigned char>(data[0]);
+            });
+
+            bool carrier = operstate == IF_OPER_UP ||
+                           (operstate == IF_OPER_UNKNOWN && (info->ifi_flags & IFF_LOWER_UP));
+
+            auto& link = links_[info->ifi_index];
+            bool changed = link.carrier != carrier || link.interface_name != name;
+            if (link.interface_name != name) link.wireless = is_wireless(name);
+            link.index = info->ifi_index;
+            link.interface_name = name;
+            link.carrier = carrier;
+            link.ipv4_addresses = static_cast<int>(addresses_[info->ifi_index].size());
+            return changed;
+        }
+        case RTM_NEWADDR:
+        case RTM_DELADDR: {
+            const auto* info = static_cast<const ifaddrmsg*>(NLMSG_DATA(msg));
+            if (info->ifa_family != AF_INET) return false;
+
+            uint32_t address = 0;
+            bool have_address = false;
+            for_each_attr(IFA_RTA(info), IFA_PAYLOAD(msg), [&](uint16_t type, const char* data, size_t len) {
+                // IFA_LOCAL is the interface's own address; IFA_ADDRESS is the peer on p2p links
+                if ((type == IFA_LOCAL || (type == IFA_ADDRESS && !have_address)) && len >= 4) {
+                    std::memcpy(&address, data, 4);
+                    have_address = true;
+                }
+            });
+            if (!have_address) return false;
+
+            auto& set = addresses_[static_cast<int>(info->ifa_index)];
+            size_t before = set.size();
+            if (msg->nlmsg_type == RTM_NEWADDR) set.insert(address);
+            else set.erase(address);
+
+            auto it = links_.find(static_cast<int>(info->ifa_index));
+            if (it != links_.end()) it->second.ipv4_addresses = static_cast<int>(set.size());
+            return set.size() != before;
+        }
+        case RTM_NEWROUTE:
+        case RTM_DELROUTE: {
+            // Only the main table's default route matters for "are we online"
+            const auto* route = static_cast<const rtmsg*>(NLMSG_DATA(msg));
+            return route->rtm_family == AF_INET && route->rtm_dst_len == 0 && route->rtm_table == RT_TABLE_MAIN;
+        }
+        default:
+            return false;
+    }
+}
+
+bool LinkMonitor::process_events() {
+    if (!socket_.valid()) return false;
+    bool changed = false;
+    socket_.read_pending([this, &changed](const nlmsghdr* msg) { changed = handle_message(msg) || changed; });
+
+    // Events were dropped, so the table can't be trusted; rebuild it from a fresh dump
+    if (socket_.take_overrun()) {
+        links_.clear();
+        addresses_.clear();
+        seeded_ = false;
+        seed();
+        changed = true;
+    }
+    return changed;
+}
+
+std::optional<std::string> LinkMonitor::find_link_up(std::string_view interface_name) const {
+    for (const auto& [index, link] : links_) {
+        if (!interface_name.empty() && link.interface_name != interface_name) continue;
+        if (interface_name.empty() && !link.wireless) continue;
+        if (link.carrier && link.ipv4_addresses > 0) return link.interface_name;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> LinkMonitor::wait_for_link_up(std::chrono::milliseconds timeout,
+                                                         std::string_view interface_name) {
+    if (!available()) return std::nullopt;
+
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + timeout;
+    const auto token = CancellationToken::current();
+
+    while (true) {
+        process_events();
+        if (auto up = find_link_up(interface_name)) return up;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0 || token.cancelled()) return std::nullopt;
+
+        pollfd pfd = { socket_.fd(), POLLIN, 0 };
+        int wait_ms = static_cast<int>(std::min<long long>(left, CancellationToken::CHECK_INTERVAL.count()));
+        if (poll(&pfd, 1, wait_ms) < 0 && errno != EINTR) return std::nullopt;
+    }
+}
+
+bool LinkMonitor::wait_for_event(std::chrono::milliseconds timeout) {
+    if (!available()) return false;
+
+    // In slices, so a cancelled connect doesn't sit out the whole timeout
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + timeout;
+    const auto token = CancellationToken::current();
+    while (!token.cancelled()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0) return false;
+
+        pollfd pfd = { socket_.fd(), POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(std::min<long long>(left, CancellationToken::CHECK_INTERVAL.count())));
+        if (ready < 0 && errno != EINTR) return false;
+        if (ready > 0) return process_events();
+    }
+    return false;
+}
+
+std::vector<LinkState> LinkMonitor::links() const {
+    std::vector<LinkState> result;
+    for (const auto& [index, link] : links_) result.push_back(link);
+    return result;
+}
+
+#else
+
+LinkMonitor::LinkMonitor(bool) : socket_(0, 0) {
+}
+
+bool LinkMonitor::available() const {
+    return false;
+}
+
+int LinkMonitor::fd() const {
+    return -1;
+}
+
+void LinkMonitor::seed() {
+}
+
+bool LinkMonitor::handle_message(const struct nlmsghdr*) {
+    return false;
+}
+
+bool LinkMonitor::process_events() {
+    return false;
+}
+
+std::optional<std::string> LinkMonitor::find_link_up(std::string_view) const {
+    return std::nullopt;
+}
+
+std::optional<std::string> LinkMonitor::wait_for_link_up(std::chrono::milliseconds, std::string_view) {
+    return std::nullopt;
+}
+
+bool LinkMonitor::wait_for_event(std::chrono::milliseconds) {
+    return false;
+}
+
+std::vector<LinkState> LinkMonitor::links() const {
+    return {};
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <string_view>
+#include <optional>
+#include <chrono>
+#include <map>
+#include <set>
+#include "netlink.h"
+
+struct LinkState {
+    int index;
+    std::string interface_name;
+    bool wireless;
+    bool carrier;      // operstate UP (associated and, for 802.1X, authenticated)
+    int ipv4_addresses;
+};
+
+// Watches rtnetlink link and IPv4 address events so the connect flow can wake
+// up the moment an interface is usable instead of sleeping and re-running
+// nmcli. Subscribes on construction, so create it before starting activation
+// to avoid missing the event. Linux only; available() is false elsewhere.
+class LinkMonitor {
+public:
+    // watch_routes also subscribes to IPv4 route events; process_events then
+    // reports default route changes too.
+    explicit LinkMonitor(bool watch_routes = false);
+
+    bool available() const;
+    int fd() const;
+
+    // Reads queued events and updates the link table. Returns true if anything changed.
+    bool process_events();
+
+    // Blocks until a wireless interface (or interface_name, if given) has carrier
+    // and an IPv4 address. Returns its name, or nullopt on timeout.
+    std::optional<std::string> wait_for_link_up(std::chrono::milliseconds timeout,
+                                                std::string_view interface_name = {});
+
+    // Waits up to timeout for the next link/address event and applies it.
+    // True if the link table changed.
+    bool wait_for_event(std::chrono::milliseconds timeout);
+
+    // Same check as wait_for_link_up without blocking.
+    std::optional<std::string> find_link_up(std::string_view interface_name = {}) const;
+
+    std::vector<LinkState> links() const;
+
+private:
+    NetlinkSocket socket_;
+    std::map<int, LinkState> links_;
+    // IPv4 addresses per ifindex; a set so repeated RTM_NEWADDR (lifetime refreshes) don't double count
+    std::map<int, std::set<uint32_t>> addresses_;
+    bool seeded_ = false;
+
+    bool handle_message(const struct nlmsghdr* msg);
+    void seed();
+};
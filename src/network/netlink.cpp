@@ -0,0 +1,196 @@
+#include "netlink.h"
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <chrono>
+#endif
+
+void append_attr(std::vector<char>& buffer, uint16_t type, const void* data, size_t length) {
+    const uint16_t header_len = 4;
+    const uint16_t attr_len = static_cast<uint16_t>(header_len + length);
+    size_t offset = buffer.size();
+    buffer.resize(offset + ((attr_len + 3u) & ~3u), 0);
+    std::memcpy(buffer.data() + offset, &attr_len, sizeof(attr_len));
+    std::memcpy(buffer.data() + offset + 2, &type, sizeof(type));
+    if (length > 0) std::memcpy(buffer.data() + offset + header_len, data, length);
+}
+
+#if defined(__linux__)
+
+NetlinkSocket::NetlinkSocket(int protocol, uint32_t groups) {
+    fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, protocol);
+    if (fd_ < 0) return;
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = groups;
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    // The kernel picks our port id; replies to our own requests carry it in nlmsg_pid
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0) port_id_ = addr.nl_pid;
+}
+
+NetlinkSocket::~NetlinkSocket() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool NetlinkSocket::add_membership(uint32_t group) {
+    if (fd_ < 0) return false;
+    return setsockopt(fd_, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) == 0;
+}
+
+uint32_t NetlinkSocket::send(uint16_t type, uint16_t flags, const void* payload, size_t length) {
+    if (fd_ < 0) return 0;
+
+    std::vector<char> buffer(NLMSG_SPACE(length), 0);
+    auto* header = reinterpret_cast<nlmsghdr*>(buffer.data());
+    header->nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(length));
+    header->nlmsg_type = type;
+    header->nlmsg_flags = static_cast<uint16_t>(flags | NLM_F_REQUEST);
+    header->nlmsg_seq = ++sequence_;
+    if (sequence_ == 0) header->nlmsg_seq = ++sequence_;
+    if (length > 0) std::memcpy(NLMSG_DATA(header), payload, length);
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+
+    while (true) {
+        ssize_t sent = sendto(fd_, buffer.data(), header->nlmsg_len, 0,
+                              reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel));
+        if (sent >= 0) return header->nlmsg_seq;
+        if (errno != EINTR) return 0;
+    }
+}
+
+bool NetlinkSocket::read_once(uint32_t seq, bool& done, bool& failed, const MessageHandler& handler) {
+    // Kernel dump batches go up to 32 KiB; keep headroom so nothing is truncated
+    if (buffer_.empty()) buffer_.resize(65536);
+    char* buffer = buffer_.data();
+    ssize_t received = recv(fd_, buffer, buffer_.size(), 0);
+    if (received < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) return true;
+        // ENOBUFS means events were dropped; flag it so the owner can re-dump its state
+        if (errno == ENOBUFS) {
+            overrun_ = true;
+            return true;
+        }
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(received);
+    for (auto* msg = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(msg, length); msg = NLMSG_NEXT(msg, length)) {
+        bool is_reply = seq != 0 && msg->nlmsg_seq == seq;
+
+        if (msg->nlmsg_type == NLMSG_DONE) {
+            if (is_reply) done = true;
+            continue;
+        }
+        if (msg->nlmsg_type == NLMSG_ERROR) {
+            if (is_reply) {
+                const auto* err = static_cast<const nlmsgerr*>(NLMSG_DATA(msg));
+                if (err->error != 0) failed = true;
+                done = true;
+            }
+            continue;
+        }
+        if (msg->nlmsg_type == NLMSG_NOOP || msg->nlmsg_type == NLMSG_OVERRUN) continue;
+        // Leftovers of an earlier request that timed out. Only our own replies count:
+        // notifications copy the seq of whoever made the change, so seq alone says nothing
+        if (!is_reply && port_id_ != 0 && msg->nlmsg_pid == port_id_) continue;
+
+        handler(msg);
+
+        // Non-dump replies are a single message
+        if (is_reply && !(msg->nlmsg_flags & NLM_F_MULTI)) done = true;
+    }
+    return true;
+}
+
+bool NetlinkSocket::read_pending(const MessageHandler& handler) {
+    if (fd_ < 0) return false;
+    while (true) {
+        pollfd pfd = { fd_, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 0);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return ready == 0;
+
+        bool done = false;
+        bool failed = false;
+        if (!read_once(0, done, failed, handler)) return false;
+    }
+}
+
+bool NetlinkSocket::take_overrun() {
+    bool overrun = overrun_;
+    overrun_ = false;
+    return overrun;
+}
+
+bool NetlinkSocket::request(uint16_t type, uint16_t flags, const void* payload, size_t length,
+                            const MessageHandler& handler, int timeout_ms) {
+    uint32_t seq = send(type, flags, payload, length);
+    if (seq == 0) return false;
+
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    bool done = false;
+    bool failed = false;
+    while (!done) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0) return false;
+
+        pollfd pfd = { fd_, POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(left));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (ready == 0) continue;
+        if (!read_once(seq, done, failed, handler)) return false;
+    }
+    return !failed;
+}
+
+#else
+
+NetlinkSocket::NetlinkSocket(int, uint32_t) {
+}
+
+NetlinkSocket::~NetlinkSocket() {
+}
+
+bool NetlinkSocket::add_membership(uint32_t) {
+    return false;
+}
+
+uint32_t NetlinkSocket::send(uint16_t, uint16_t, const void*, size_t) {
+    return 0;
+}
+
+bool NetlinkSocket::read_pending(const MessageHandler&) {
+    return false;
+}
+
+bool NetlinkSocket::take_overrun() {
+    return false;
+}
+
+bool NetlinkSocket::request(uint16_t, uint16_t, const void*, size_t, const MessageHandler&, int) {
+    return false;
+}
+
+bool NetlinkSocket::read_once(uint32_t, bool&, bool&, const MessageHandler&) {
+    return false;
+}
+
+#endif
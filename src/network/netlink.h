@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+// Thin RAII wrapper around a raw AF_NETLINK socket. Linux only; on other
+// platforms the socket is never valid. Used by the link monitor (rtnetlink)
+// and the nl80211 status/scan code (generic netlink).
+class NetlinkSocket {
+public:
+    using MessageHandler = std::function<void(const struct nlmsghdr*)>;
+
+    // groups is the legacy multicast bitmask (e.g. RTMGRP_LINK) to subscribe to.
+    NetlinkSocket(int protocol, uint32_t groups = 0);
+    ~NetlinkSocket();
+
+    NetlinkSocket(const NetlinkSocket&) = delete;
+    NetlinkSocket& operator=(const NetlinkSocket&) = delete;
+
+    bool valid() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // Joins a multicast group by id (needed for generic netlink families).
+    bool add_membership(uint32_t group);
+
+    // Sends one request. payload follows the nlmsghdr. Returns the sequence number, 0 on failure.
+    uint32_t send(uint16_t type, uint16_t flags, const void* payload, size_t length);
+
+    // Reads whatever is queued without blocking and hands every message to handler.
+    // Returns false if the socket failed.
+    bool read_pending(const MessageHandler& handler);
+
+    // True once after the receive buffer overflowed and events were lost.
+    bool take_overrun();
+
+    // Sends a request and reads replies until NLMSG_DONE/ACK/error for that sequence.
+    // Multicast events that arrive in between are handed to handler as well.
+    // Returns false on a netlink error reply or socket failure.
+    bool request(uint16_t type, uint16_t flags, const void* payload, size_t length,
+                 const MessageHandler& handler, int timeout_ms = 1000);
+
+private:
+    int fd_ = -1;
+    uint32_t sequence_ = 0;
+    uint32_t port_id_ = 0;
+    bool overrun_ = false;
+    std::vector<char> buffer_;
+
+    // Reads one datagram and dispatches it. Sets done when the reply to seq is complete.
+    bool read_once(uint32_t seq, bool& done, bool& failed, const MessageHandler& handler);
+};
+
+// Appends one attribute (4 byte header + payload, padded to 4) to a request being built.
+void append_attr(std::vector<char>& buffer, uint16_t type, const void* data, size_t length);
+
+#if defined(__linux__)
+// Walks the rtattr/nlattr list after a fixed header. Works for both, they share a layout.
+template <typename Fn>
+void for_each_attr(const void* data, size_t length, Fn&& fn) {
+    const auto* attr = static_cast<const struct nlattr*>(data);
+    while (length >= sizeof(struct nlattr) && attr->nla_len >= sizeof(struct nlattr) && attr->nla_len <= length) {
+        fn(static_cast<uint16_t>(attr->nla_type & NLA_TYPE_MASK),
+           reinterpret_cast<const char*>(attr) + NLA_HDRLEN,
+           static_cast<size_t>(attr->nla_len - NLA_HDRLEN));
+        size_t step = NLA_ALIGN(attr->nla_len);
+        if (step >= length) break;
+        length -= step;
+        attr = reinterpret_cast<const struct nlattr*>(reinterpret_cast<const char*>(attr) + step);
+    }
+}
+#endif
@@ -0,0 +1,305 @@
+#include "nl80211.h"
+#include "../utils/cancellation.h"
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#endif
+
+std::string format_mac(const unsigned char* bytes) {
+    char text[18];
+    std::snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x",
+                  bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+    return text;
+}
+
+bool parse_mac(std::string_view text, unsigned char* bytes) {
+    if (text.size() != 17) return false;
+    for (size_t i = 0; i < 6; ++i) {
+        if (i > 0 && text[i * 3 - 1] != ':') return false;
+        unsigned value = 0;
+        for (size_t j = 0; j < 2; ++j) {
+            char c = text[i * 3 + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        bytes[i] = static_cast<unsigned char>(value);
+    }
+    return true;
+}
+
+int channel_load_from_ies(const unsigned char* data, size_t length) {
+    size_t pos = 0;
+    while (pos + 2 <= length) {
+        unsigned id = data[pos];
+        unsigned len = data[pos + 1];
+        if (pos + 2 + len > length) break;
+        // Station count (2 bytes), channel utilization (1), admission capacity (2)
+        if (id == 11 && len >= 3) return data[pos + 4];
+        pos += 2 + len;
+    }
+    return -1;
+}
+
+Nl80211& Nl80211::instance() {
+    static Nl80211 instance;
+    return instance;
+}
+
+#if defined(__linux__)
+
+namespace {
+
+    std::vector<char> genl_request(uint8_t cmd) {
+        std::vector<char> payload(GENL_HDRLEN, 0);
+        auto* header = reinterpret_cast<genlmsghdr*>(payload.data());
+        header->cmd = cmd;
+        header->version = 1;
+        return payload;
+    }
+
+    const char* genl_attrs(const nlmsghdr* msg) {
+        return static_cast<const char*>(NLMSG_DATA(msg)) + GENL_HDRLEN;
+    }
+
+    size_t genl_attrs_length(const nlmsghdr* msg) {
+        return msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    }
+
+    uint32_t read_u32(const char* data) {
+        uint32_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // The SSID element (id 0) from a BSS's information elements.
+    std::string ssid_from_ies(const char* data, size_t length) {
+        size_t pos = 0;
+        while (pos + 2 <= length) {
+            auto id = static_cast<unsigned char>(data[pos]);
+            auto len = static_cast<unsigned char>(data[pos + 1]);
+            if (pos + 2 + len > length) break;
+            if (id == 0) return std::string(data + pos + 2, len);
+            pos += 2 + len;
+        }
+        return "";
+    }
+
+}
+
+Nl80211::Nl80211() : socket_(NETLINK_GENERIC) {
+}
+
+bool Nl80211::resolve_family() {
+    if (resolved_) return family_id_ != 0;
+    resolved_ = true;
+    if (!socket_.valid()) return false;
+
+    auto payload = genl_request(CTRL_CMD_GETFAMILY);
+    const char name[] = "nl80211";
+    append_attr(payload, CTRL_ATTR_FAMILY_NAME, name, sizeof(name));
+
+    socket_.request(GENL_ID_CTRL, 0, payload.data(), payload.size(), [this](const nlmsghdr* msg) {
+        if (msg->nlmsg_type != GENL_ID_CTRL) return;
+        for_each_attr(genl_attrs(msg), genl_attrs_length(msg), [this](uint16_t type, const char* data, size_t len) {
+            if (type == CTRL_ATTR_FAMILY_ID && len >= 2) {
+                std::memcpy(&family_id_, data, sizeof(family_id_));
+            } else if (type == CTRL_ATTR_MCAST_GROUPS) {
+                // Nested list of { name, id } entries
+                for_each_attr(data, len, [this](uint16_t, const char* group, size_t group_len) {
+                    std::string name;
+                    uint32_t id = 0;
+                    for_each_attr(group, group_len, [&](uint16_t field, const char* value, size_t value_len) {
+                        if (field == CTRL_ATTR_MCAST_GRP_NAME) name.assign(value, strnlen(value, value_len));
+                        else if (field == CTRL_ATTR_MCAST_GRP_ID && value_len >= 4) id = read_u32(value);
+                    });
+                    if (name == "scan") scan_group_ = id;
+                });
+            }
+        });
+    });
+    return family_id_ != 0;
+}
+
+bool Nl80211::available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resolve_family();
+}
+
+std::vector<WirelessInterface> Nl80211::get_interfaces() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<WirelessInterface> interfaces;
+    if (!resolve_family()) return interfaces;
+
+    auto payload = genl_request(NL80211_CMD_GET_INTERFACE);
+    socket_.request(family_id_, NLM_F_DUMP, payload.data(), payload.size(), [&](const nlmsghdr* msg) {
+        if (msg->nlmsg_type != family_id_) return;
+
+        WirelessInterface iface{ 0, "", "" };
+        uint32_t iftype = NL80211_IFTYPE_UNSPECIFIED;
+        for_each_attr(genl_attrs(msg), genl_attrs_length(msg), [&](uint16_t type, const char* data, size_t len) {
+            if (type == NL80211_ATTR_IFINDEX && len >= 4) iface.index = static_cast<int>(read_u32(data));
+            else if (type == NL80211_ATTR_IFNAME && len > 0) iface.name.assign(data, strnlen(data, len));
+            else if (type == NL80211_ATTR_SSID) iface.ssid.assign(data, len);
+            else if (type == NL80211_ATTR_IFTYPE && len >= 4) iftype = read_u32(data);
+        });
+
+        // P2P-device and monitor vifs have no netdev worth reporting
+        if (iface.index > 0 && (iftype == NL80211_IFTYPE_STATION || iftype == NL80211_IFTYPE_UNSPECIFIED)) {
+            interfaces.push_back(std::move(iface));
+        }
+    });
+    return interfaces;
+}
+
+std::vector<BssEntry> Nl80211::get_scan_results(int interface_index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<BssEntry> results;
+    if (!resolve_family()) return results;
+
+    auto payload = genl_request(NL80211_CMD_GET_SCAN);
+    uint32_t index = static_cast<uint32_t>(interface_index);
+    append_attr(payload, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+
+    socket_.request(family_id_, NLM_F_DUMP, payload.data(), payload.size(), [&](const nlmsghdr* msg) {
+        if (msg->nlmsg_type != family_id_) return;
+
+        for_each_attr(genl_attrs(msg), genl_attrs_length(msg), [&](uint16_t type, const char* data, size_t len) {
+            if (type != NL80211_ATTR_BSS) return;
+
+            BssEntry bss{ "", "", 0, 0, false, -1 };
+            for_each_attr(data, len, [&](uint16_t bss_type, const char* value, size_t value_len) {
+                switch (bss_type) {
+                    case NL80211_BSS_BSSID:
+                        if (value_len >= 6) bss.bssid = format_mac(reinterpret_cast<const unsigned char*>(value));
+                        break;
+                    case NL80211_BSS_FREQUENCY:
+                        if (value_len >= 4) bss.frequency_mhz = static_cast<int>(read_u32(value));
+                        break;
+                    case NL80211_BSS_SIGNAL_MBM:
+                        if (value_len >= 4) bss.signal_mbm = static_cast<int32_t>(read_u32(value));
+                        break;
+                    case NL80211_BSS_STATUS:
+                        if (value_len >= 4) bss.associated = read_u32(value) == NL80211_BSS_STATUS_ASSOCIATED;
+                        break;
+                    case NL80211_BSS_INFORMATION_ELEMENTS:
+                        bss.ssid = ssid_from_ies(value, value_len);
+                        bss.channel_load = channel_load_from_ies(reinterpret_cast<const unsigned char*>(value), value_len);
+                        break;
+                    default:
+                        break;
+                }
+            });
+            if (!bss.bssid.empty()) results.push_back(std::move(bss));
+        });
+    }, 2000);
+    return results;
+}
+
+bool Nl80211::trigger_scan(int interface_index, std::string_view ssid, int timeout_ms) {
+    // Join the scan group on a socket of our own before triggering, so the
+    // completion event can't arrive before we're listening. Only the trigger
+    // holds the lock; the wait happens on that socket.
+    NetlinkSocket events(NETLINK_GENERIC);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!resolve_family() || scan_group_ == 0 || !events.add_membership(scan_group_)) return false;
+
+    auto payload = genl_request(NL80211_CMD_TRIGGER_SCAN);
+    uint32_t index = static_cast<uint32_t>(interface_index);
+    append_attr(payload, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+    if (!ssid.empty()) {
+        std::vector<char> ssids;
+        append_attr(ssids, 1, ssid.data(), ssid.size());
+        append_attr(payload, NLA_F_NESTED | NL80211_ATTR_SCAN_SSIDS, ssids.data(), ssids.size());
+    }
+    // EBUSY (NetworkManager is already scanning) and EPERM both land here
+    if (!socket_.request(family_id_, NLM_F_ACK, payload.data(), payload.size(), [](const nlmsghdr*) {})) return false;
+    const uint16_t family = family_id_;
+    lock.unlock();
+
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    const auto token = CancellationToken::current();
+    int outcome = 0;   // 1 new results, -1 aborted
+    while (outcome == 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0 || token.cancelled()) return false;
+
+        pollfd pfd = { events.fd(), POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(std::min<long long>(left, CancellationToken::CHECK_INTERVAL.count())));
+        if (ready < 0 && errno != EINTR) return false;
+        if (ready <= 0) continue;
+
+        events.read_pending([&](const nlmsghdr* msg) {
+            if (msg->nlmsg_type != family) return;
+            auto cmd = static_cast<const genlmsghdr*>(NLMSG_DATA(msg))->cmd;
+            if (cmd != NL80211_CMD_NEW_SCAN_RESULTS && cmd != NL80211_CMD_SCAN_ABORTED) return;
+
+            uint32_t event_index = 0;
+            for_each_attr(genl_attrs(msg), genl_attrs_length(msg), [&](uint16_t type, const char* data, size_t len) {
+                if (type == NL80211_ATTR_IFINDEX && len >= 4) event_index = read_u32(data);
+            });
+            if (event_index == index) outcome = cmd == NL80211_CMD_NEW_SCAN_RESULTS ? 1 : -1;
+        });
+    }
+    return outcome > 0;
+}
+
+std::string Nl80211::get_station_bssid(int interface_index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string bssid;
+    if (!resolve_family()) return bssid;
+
+    // In station mode the only station entry is the AP we're associated with
+    auto payload = genl_request(NL80211_CMD_GET_STATION);
+    uint32_t index = static_cast<uint32_t>(interface_index);
+    append_attr(payload, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+
+    socket_.request(family_id_, NLM_F_DUMP, payload.data(), payload.size(), [&](const nlmsghdr* msg) {
+        if (msg->nlmsg_type != family_id_ || !bssid.empty()) return;
+        for_each_attr(genl_attrs(msg), genl_attrs_length(msg), [&](uint16_t type, const char* data, size_t len) {
+            if (type == NL80211_ATTR_MAC && len >= 6) bssid = format_mac(reinterpret_cast<const unsigned char*>(data));
+        });
+    });
+    return bssid;
+}
+
+#else
+
+Nl80211::Nl80211() : socket_(0) {
+}
+
+bool Nl80211::resolve_family() {
+    return false;
+}
+
+bool Nl80211::available() {
+    return false;
+}
+
+std::vector<WirelessInterface> Nl80211::get_interfaces() {
+    return {};
+}
+
+std::vector<BssEntry> Nl80211::get_scan_results(int) {
+    return {};
+}
+
+bool Nl80211::trigger_scan(int, std::string_view, int) {
+    return false;
+}
+
+std::string Nl80211::get_station_bssid(int) {
+    return "";
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <string_view>
+#include "netlink.h"
+
+struct WirelessInterface {
+    int index;
+    std::string name;
+    std::string ssid;   // empty unless associated
+};
+
+struct BssEntry {
+    std::string bssid;  // aa:bb:cc:dd:ee:ff
+    std::string ssid;
+    int frequency_mhz;
+    int signal_mbm;     // 1/100 dBm
+    bool associated;
+    int channel_load;   // 0-255 from the BSS Load element, -1 if the AP doesn't advertise it
+};
+
+// Minimal nl80211 client over generic netlink: enough to read interface
+// association state and the kernel's cached BSS list without spawning
+// iw/nmcli. One socket is kept open and shared behind a mutex.
+// Linux only; available() is false elsewhere.
+class Nl80211 {
+public:
+    static Nl80211& instance();
+
+    bool available();
+
+    std::vector<WirelessInterface> get_interfaces();
+    std::vector<BssEntry> get_scan_results(int interface_index);
+
+    // Asks the kernel for a fresh scan (probing for ssid, if given) and waits
+    // up to timeout_ms for it to finish, so get_scan_results() is current.
+    // Needs CAP_NET_ADMIN; false if the scan couldn't be started or didn't
+    // finish in time, in which case the cached results are all there is.
+    bool trigger_scan(int interface_index, std::string_view ssid, int timeout_ms);
+
+    // MAC of the AP a station interface is associated with, empty if none.
+    std::string get_station_bssid(int interface_index);
+
+private:
+    Nl80211();
+
+    NetlinkSocket socket_;
+    std::mutex mutex_;
+    uint16_t family_id_ = 0;
+    uint32_t scan_group_ = 0;   // "scan" multicast group, for NEW_SCAN_RESULTS
+    bool resolved_ = false;
+
+    bool resolve_family();
+};
+
+// Formats 6 raw bytes as a lower-case colon separated MAC address.
+std::string format_mac(const unsigned char* bytes);
+
+// Parses "aa:bb:cc:dd:ee:ff" (either case) into 6 bytes. False if malformed.
+bool parse_mac(std::string_view text, unsigned char* bytes);
+
+// Channel utilization (0-255) from the BSS Load element (id 11) in a raw
+// information element list, -1 if there is none.
+int channel_load_from_ies(const unsigned char* data, size_t length);
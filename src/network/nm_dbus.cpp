@@ -0,0 +1,585 @@
+#include "nm_dbus.h"
+#include "nl80211.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/cancellation.h"
+
+#if defined(AUTOCONNECT_HAVE_DBUS)
+#include <dbus/dbus.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <map>
+#include <memory>
+#endif
+
+NmDbus& NmDbus::instance() {
+    static NmDbus instance;
+    return instance;
+}
+
+#if defined(AUTOCONNECT_HAVE_DBUS)
+
+namespace {
+
+    const char* NM_SERVICE = "org.freedesktop.NetworkManager";
+    const char* NM_PATH = "/org/freedesktop/NetworkManager";
+    const char* NM_IFACE = "org.freedesktop.NetworkManager";
+    const char* SETTINGS_PATH = "/org/freedesktop/NetworkManager/Settings";
+    const char* SETTINGS_IFACE = "org.freedesktop.NetworkManager.Settings";
+    const char* CONNECTION_IFACE = "org.freedesktop.NetworkManager.Settings.Connection";
+    const char* DEVICE_IFACE = "org.freedesktop.NetworkManager.Device";
+    const char* WIRELESS_IFACE = "org.freedesktop.NetworkManager.Device.Wireless";
+    const char* ACCESS_POINT_IFACE = "org.freedesktop.NetworkManager.AccessPoint";
+    const char* ACTIVE_IFACE = "org.freedesktop.NetworkManager.Connection.Active";
+    const char* PROPERTIES_IFACE = "org.freedesktop.DBus.Properties";
+
+    const char* STATE_MATCH =
+        "type='signal',sender='org.freedesktop.NetworkManager',"
+        "interface='org.freedesktop.NetworkManager.Connection.Active',member='StateChanged'";
+
+    const uint32_t DEVICE_TYPE_WIFI = 2;
+    const uint32_t ACTIVE_STATE_ACTIVATED = 2;
+    const uint32_t ACTIVE_STATE_DEACTIVATED = 4;
+
+    const int CALL_TIMEOUT_MS = 10000;
+
+    struct MessageDeleter {
+        void operator()(DBusMessage* msg) const { dbus_message_unref(msg); }
+    };
+    using Message = std::unique_ptr<DBusMessage, MessageDeleter>;
+
+    // One settings value. Only the D-Bus types NetworkManager uses for our profile.
+    struct SettingValue {
+        enum Kind { String, Bytes, StringList, Boolean, Uint32 } kind;
+        std::string text;
+        std::vector<std::string> list;
+        uint32_t number = 0;
+    };
+    using Settings = std::map<std::string, std::map<std::string, SettingValue>>;
+
+    SettingValue string_value(std::string text) { return { SettingValue::String, std::move(text), {}, 0 }; }
+    SettingValue bytes_value(std::string bytes) { return { SettingValue::Bytes, std::move(bytes), {}, 0 }; }
+    SettingValue list_value(std::vector<std::string> list) { return { SettingValue::StringList, "", std::move(list), 0 }; }
+    SettingValue bool_value(bool flag) { return { SettingValue::Boolean, "", {}, flag ? 1u : 0u }; }
+    SettingValue uint_value(uint32_t number) { return { SettingValue::Uint32, "", {}, number }; }
+
+    Settings to_settings(const NmProfile& profile, const std::string& uuid) {
+        Settings s;
+        s["connection"]["id"] = string_value(profile.id);
+        s["connection"]["type"] = string_value("802-11-wireless");
+        s["connection"]["autoconnect"] = bool_value(true);
+        if (!uuid.empty()) s["connection"]["uuid"] = string_value(uuid);
+        if (!profile.interface_name.empty()) s["connection"]["interface-name"] = string_value(profile.interface_name);
+
+        s["802-11-wireless"]["ssid"] = bytes_value(profile.ssid);
+        s["802-11-wireless"]["mode"] = string_value("infrastructure");
+        unsigned char mac[6];
+        if (!profile.bssid.empty() && parse_mac(profile.bssid, mac)) {
+            s["802-11-wireless"]["bssid"] = bytes_value(std::string(reinterpret_cast<const char*>(mac), sizeof(mac)));
+        }
+        s["802-11-wireless-security"]["key-mgmt"] = string_value("wpa-eap");
+
+        auto& eap = s["802-1x"];
+        eap["eap"] = list_value({ profile.eap });
+        eap["phase2-auth"] = string_value(profile.phase2_auth);
+        eap["identity"] = string_value(profile.identity);
+        if (!profile.anonymous_identity.empty()) eap["anonymous-identity"] = string_value(profile.anonymous_identity);
+        eap["password"] = string_value(profile.password);
+        eap["password-flags"] = uint_value(0);
+        eap["system-ca-certs"] = bool_value(false);
+
+        s["ipv4"]["method"] = string_value("auto");
+        s["ipv6"]["method"] = string_value("auto");
+        return s;
+    }
+
+    void append_string(DBusMessageIter* it, const std::string& text) {
+        const char* value = text.c_str();
+        dbus_message_iter_append_basic(it, DBUS_TYPE_STRING, &value);
+    }
+
+    void append_path(DBusMessageIter* it, const std::string& path) {
+        const char* value = path.c_str();
+        dbus_message_iter_append_basic(it, DBUS_TYPE_OBJECT_PATH, &value);
+    }
+
+    void append_variant(DBusMessageIter* it, const SettingValue& value) {
+        static const char* signatures[] = { "s", "ay", "as", "b", "u" };
+        DBusMessageIter variant, array;
+        dbus_message_iter_open_container(it, DBUS_TYPE_VARIANT, signatures[value.kind], &variant);
+        switch (value.kind) {
+            case SettingValue::String:
+                append_string(&variant, value.text);
+                break;
+            case SettingValue::Bytes: {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(value.text.data());
+                dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "y", &array);
+                dbus_message_iter_append_fixed_array(&array, DBUS_TYPE_BYTE, &bytes, static_cast<int>(value.text.size()));
+                dbus_message_iter_close_container(&variant, &array);
+                break;
+            }
+            case SettingValue::StringList:
+                dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "s", &array);
+                for (const auto& item : value.list) append_string(&array, item);
+                dbus_message_iter_close_container(&variant, &array);
+                break;
+            case SettingValue::Boolean: {
+                dbus_bool_t flag = value.number ? TRUE : FALSE;
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_BOOLEAN, &flag);
+                break;
+            }
+            case SettingValue::Uint32:
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32, &value.number);
+                break;
+        }
+        dbus_message_iter_close_container(it, &variant);
+    }
+
+    // a{sa{sv}}
+    void append_settings(DBusMessageIter* it, const Settings& settings) {
+        DBusMessageIter groups;
+        dbus_message_iter_open_container(it, DBUS_TYPE_ARRAY, "{sa{sv}}", &groups);
+        for (const auto& [group, values] : settings) {
+            DBusMessageIter group_entry, keys;
+            dbus_message_iter_open_container(&groups, DBUS_TYPE_DICT_ENTRY, nullptr, &group_entry);
+            append_string(&group_entry, group);
+            dbus_message_iter_open_container(&group_entry, DBUS_TYPE_ARRAY, "{sv}", &keys);
+            for (const auto& [key, value] : values) {
+                DBusMessageIter key_entry;
+                dbus_message_iter_open_container(&keys, DBUS_TYPE_DICT_ENTRY, nullptr, &key_entry);
+                append_string(&key_entry, key);
+                append_variant(&key_entry, value);
+                dbus_message_iter_close_container(&keys, &key_entry);
+            }
+            dbus_message_iter_close_container(&group_entry, &keys);
+            dbus_message_iter_close_container(&groups, &group_entry);
+        }
+        dbus_message_iter_close_container(it, &groups);
+    }
+
+    // Reads a variant holding s, o, ay or as into text/list; other types are skipped.
+    SettingValue read_variant(DBusMessageIter* it) {
+        SettingValue value{ SettingValue::String, "", {}, 0 };
+        DBusMessageIter variant;
+        dbus_message_iter_recurse(it, &variant);
+
+        int type = dbus_message_iter_get_arg_type(&variant);
+        if (type == DBUS_TYPE_STRING || type == DBUS_TYPE_OBJECT_PATH) {
+            const char* text = nullptr;
+            dbus_message_iter_get_basic(&variant, &text);
+            value.text = text ? text : "";
+        } else if (type == DBUS_TYPE_UINT32) {
+            value.kind = SettingValue::Uint32;
+            dbus_message_iter_get_basic(&variant, &value.number);
+        } else if (type == DBUS_TYPE_ARRAY) {
+            DBusMessageIter array;
+            int element = dbus_message_iter_get_element_type(&variant);
+            dbus_message_iter_recurse(&variant, &array);
+            if (element == DBUS_TYPE_BYTE) {
+                value.kind = SettingValue::Bytes;
+                const unsigned char* bytes = nullptr;
+                int length = 0;
+                dbus_message_iter_get_fixed_array(&array, &bytes, &length);
+                if (bytes) value.text.assign(reinterpret_cast<const char*>(bytes), static_cast<size_t>(length));
+            } else if (element == DBUS_TYPE_STRING || element == DBUS_TYPE_OBJECT_PATH) {
+                value.kind = SettingValue::StringList;
+                while (dbus_message_iter_get_arg_type(&array) != DBUS_TYPE_INVALID) {
+                    const char* text = nullptr;
+                    dbus_message_iter_get_basic(&array, &text);
+                    value.list.push_back(text ? text : "");
+                    dbus_message_iter_next(&array);
+                }
+            }
+        }
+        return value;
+    }
+
+    Settings read_settings(DBusMessageIter* it) {
+        Settings settings;
+        if (dbus_message_iter_get_arg_type(it) != DBUS_TYPE_ARRAY) return settings;
+
+        DBusMessageIter groups;
+        dbus_message_iter_recurse(it, &groups);
+        while (dbus_message_iter_get_arg_type(&groups) == DBUS_TYPE_DICT_ENTRY) {
+            DBusMessageIter group_entry, keys;
+            dbus_message_iter_recurse(&groups, &group_entry);
+            const char* group = nullptr;
+            dbus_message_iter_get_basic(&group_entry, &group);
+            dbus_message_iter_next(&group_entry);
+            dbus_message_iter_recurse(&group_entry, &keys);
+
+            while (dbus_message_iter_get_arg_type(&keys) == DBUS_TYPE_DICT_ENTRY) {
+                DBusMessageIter key_entry;
+                dbus_message_iter_recurse(&keys, &key_entry);
+                const char* key = nullptr;
+                dbus_message_iter_get_basic(&key_entry, &key);
+                dbus_message_iter_next(&key_entry);
+                settings[group][key] = read_variant(&key_entry);
+                dbus_message_iter_next(&keys);
+            }
+            dbus_message_iter_next(&groups);
+        }
+        return settings;
+    }
+
+    std::string setting_text(const Settings& settings, const std::string& group, const std::string& key) {
+        auto g = settings.find(group);
+        if (g == settings.end()) return "";
+        auto k = g->second.find(key);
+        if (k == g->second.end()) return "";
+        if (k->second.kind == SettingValue::StringList) return k->second.list.empty() ? "" : k->second.list.front();
+        return k->second.text;
+    }
+
+    template <typename AppendArgs>
+    Message call(DBusConnection* conn, const std::string& path, const char* iface, const char* method,
+                 AppendArgs append, std::string* error = nullptr, int timeout_ms = CALL_TIMEOUT_MS) {
+        Message msg(dbus_message_new_method_call(NM_SERVICE, path.c_str(), iface, method));
+        if (!msg) return nullptr;
+        DBusMessageIter args;
+        dbus_message_iter_init_append(msg.get(), &args);
+        append(&args);
+
+        DBusError err;
+        dbus_error_init(&err);
+        Message reply(dbus_connection_send_with_reply_and_block(conn, msg.get(), timeout_ms, &err));
+        if (dbus_error_is_set(&err)) {
+            if (error) *error = err.message ? err.message : err.name;
+            dbus_error_free(&err);
+            return nullptr;
+        }
+        return reply;
+    }
+
+    Message call(DBusConnection* conn, const std::string& path, const char* iface, const char* method,
+                 std::string* error = nullptr) {
+        return call(conn, path, iface, method, [](DBusMessageIter*) {}, error);
+    }
+
+    SettingValue get_property(DBusConnection* conn, const std::string& path, const char* iface, const char* name) {
+        auto reply = call(conn, path, PROPERTIES_IFACE, "Get", [&](DBusMessageIter* it) {
+            append_string(it, iface);
+            append_string(it, name);
+        });
+        if (!reply) return { SettingValue::String, "", {}, 0 };
+        DBusMessageIter it;
+        dbus_message_iter_init(reply.get(), &it);
+        return read_variant(&it);
+    }
+
+    // The last object path argument of a reply: AddAndActivateConnection
+    // returns (connection, active), ActivateConnection just (active)
+    std::string last_path_arg(DBusMessage* reply) {
+        std::string path;
+        DBusMessageIter it;
+        if (!reply || !dbus_message_iter_init(reply, &it)) return path;
+        do {
+            if (dbus_message_iter_get_arg_type(&it) != DBUS_TYPE_OBJECT_PATH) continue;
+            const char* value = nullptr;
+            dbus_message_iter_get_basic(&it, &value);
+            path = value;
+        } while (dbus_message_iter_next(&it));
+        return path;
+    }
+
+    // ao from a reply
+    std::vector<std::string> reply_paths(DBusMessage* reply) {
+        std::vector<std::string> paths;
+        DBusMessageIter it;
+        if (!reply || !dbus_message_iter_init(reply, &it)) return paths;
+
+        if (dbus_message_iter_get_arg_type(&it) == DBUS_TYPE_ARRAY) {
+            DBusMessageIter array;
+            dbus_message_iter_recurse(&it, &array);
+            while (dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_OBJECT_PATH) {
+                const char* path = nullptr;
+                dbus_message_iter_get_basic(&array, &path);
+                paths.push_back(path);
+                dbus_message_iter_next(&array);
+            }
+        }
+        return paths;
+    }
+
+
+    std::string find_connection(DBusConnection* conn, std::string_view id, std::string* uuid = nullptr) {
+        auto list = call(conn, SETTINGS_PATH, SETTINGS_IFACE, "ListConnections");
+        for (const auto& path : reply_paths(list.get())) {
+            auto reply = call(conn, path, CONNECTION_IFACE, "GetSettings");
+            if (!reply) continue;
+            DBusMessageIter it;
+            dbus_message_iter_init(reply.get(), &it);
+            Settings settings = read_settings(&it);
+            if (setting_text(settings, "connection", "id") == id) {
+                if (uuid) *uuid = setting_text(settings, "connection", "uuid");
+                return path;
+            }
+        }
+        return "";
+    }
+
+    // The named WiFi device, or the first one when no name is given. A name that
+    // doesn't match gives "": falling back would let two parallel activations
+    // land on the same radio.
+    std::string find_wifi_device(DBusConnection* conn, std::string_view interface_name) {
+        auto reply = call(conn, NM_PATH, NM_IFACE, "GetDevices");
+        for (const auto& path : reply_paths(reply.get())) {
+            if (get_property(conn, path, DEVICE_IFACE, "DeviceType").number != DEVICE_TYPE_WIFI) continue;
+            if (interface_name.empty()) return path;
+            if (get_property(conn, path, DEVICE_IFACE, "Interface").text == interface_name) return path;
+        }
+        return "";
+    }
+
+    // Object path of the access point with this BSSID as the device sees it, "/" if none
+    std::string find_access_point(DBusConnection* conn, const std::string& device, std::string_view bssid) {
+        if (bssid.empty()) return "/";
+        for (const auto& path : get_property(conn, device, WIRELESS_IFACE, "AccessPoints").list) {
+            std::string address = get_property(conn, path, ACCESS_POINT_IFACE, "HwAddress").text;
+            std::transform(address.begin(), address.end(), address.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (address == bssid) return path;
+        }
+        return "/";
+    }
+
+    // Private connection to the system bus. Honours DBUS_SYSTEM_BUS_ADDRESS, so
+    // a private bus can stand in for the real one.
+    DBusConnection* open_connection() {
+        DBusError err;
+        dbus_error_init(&err);
+        DBusConnection* conn = dbus_bus_get_private(DBUS_BUS_SYSTEM, &err);
+        if (dbus_error_is_set(&err)) dbus_error_free(&err);
+        if (conn) dbus_connection_set_exit_on_disconnect(conn, FALSE);
+        return conn;
+    }
+
+    struct ConnectionCloser {
+        void operator()(DBusConnection* conn) const {
+            dbus_connection_close(conn);
+            dbus_connection_unref(conn);
+        }
+    };
+
+}
+
+NmDbus::NmDbus() {
+    dbus_threads_init_default();
+}
+
+NmDbus::~NmDbus() {
+    if (connection_) {
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+    }
+}
+
+bool NmDbus::ensure_connected() {
+    if (connection_ && dbus_connection_get_is_connected(connection_)) return true;
+    if (connection_) {
+        // Private connections must be closed before the last unref
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+        connection_ = nullptr;
+    }
+
+    connection_ = open_connection();
+    return connection_ != nullptr;
+}
+
+bool NmDbus::available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensure_connected()) return false;
+
+    DBusError err;
+    dbus_error_init(&err);
+    bool owned = dbus_bus_name_has_owner(connection_, NM_SERVICE, &err);
+    if (dbus_error_is_set(&err)) {
+        dbus_error_free(&err);
+        return false;
+    }
+    return owned;
+}
+
+std::optional<NmProfile> NmDbus::read_profile(std::string_view id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensure_connected()) return std::nullopt;
+
+    std::string path = find_connection(connection_, id);
+    if (path.empty()) return std::nullopt;
+
+    auto reply = call(connection_, path, CONNECTION_IFACE, "GetSettings");
+    if (!reply) return std::nullopt;
+    DBusMessageIter it;
+    dbus_message_iter_init(reply.get(), &it);
+    Settings settings = read_settings(&it);
+
+    NmProfile profile;
+    profile.id = std::string(id);
+    profile.interface_name = setting_text(settings, "connection", "interface-name");
+    profile.ssid = setting_text(settings, "802-11-wireless", "ssid");
+    std::string bssid = setting_text(settings, "802-11-wireless", "bssid");
+    if (bssid.size() == 6) profile.bssid = format_mac(reinterpret_cast<const unsigned char*>(bssid.data()));
+    profile.eap = setting_text(settings, "802-1x", "eap");
+    profile.phase2_auth = setting_text(settings, "802-1x", "phase2-auth");
+    profile.identity = setting_text(settings, "802-1x", "identity");
+    profile.anonymous_identity = setting_text(settings, "802-1x", "anonymous-identity");
+
+    auto secrets = call(connection_, path, CONNECTION_IFACE, "GetSecrets", [](DBusMessageIter* args) {
+        append_string(args, "802-1x");
+    });
+    if (secrets) {
+        dbus_message_iter_init(secrets.get(), &it);
+        profile.password = setting_text(read_settings(&it), "802-1x", "password");
+    }
+    return profile;
+}
+
+NmDbusResult NmDbus::activate(const NmProfile& profile, bool write, int timeout_ms, std::string_view access_point) {
+    // Own connection rather than the shared one: the wait below can take a
+    // while, and several activations (one per interface) may run at once
+    std::unique_ptr<DBusConnection, ConnectionCloser> owned(open_connection());
+    if (!owned) return { false, "D-Bus not connected" };
+    DBusConnection* conn = owned.get();
+
+    std::string device = find_wifi_device(conn, profile.interface_name);
+    if (device.empty()) {
+        if (profile.interface_name.empty()) return { false, "No WiFi device known to NetworkManager" };
+        return { false, "NetworkManager has no WiFi device " + profile.interface_name };
+    }
+    // Preferred for this activation only; the stored profile keeps roaming freely
+    const std::string specific_object = find_access_point(conn, device, access_point);
+
+    // Match before activating so no StateChanged can arrive before we listen
+    DBusError err;
+    dbus_error_init(&err);
+    dbus_bus_add_match(conn, STATE_MATCH, &err);
+    if (dbus_error_is_set(&err)) {
+        std::string message = err.message ? err.message : "AddMatch failed";
+        dbus_error_free(&err);
+        return { false, message };
+    }
+
+    std::string error;
+    std::string uuid;
+    std::string connpath = find_connection(conn, profile.id, &uuid);
+    Message reply;
+
+    if (connpath.empty()) {
+        // Writes and activates in one round trip, so the profile write isn't timed separately here
+        reply = call(conn, NM_PATH, NM_IFACE, "AddAndActivateConnection", [&](DBusMessageIter* args) {
+            append_settings(args, to_settings(profile, ""));
+            append_path(args, device);
+            append_path(args, specific_object);
+        }, &error);
+    } else {
+        if (write) {
+            ScopedSpan span("wifi.profile_write");
+            auto updated = call(conn, connpath, CONNECTION_IFACE, "Update", [&](DBusMessageIter* args) {
+                append_settings(args, to_settings(profile, uuid));
+            }, &error);
+            if (!updated) {
+                dbus_bus_remove_match(conn, STATE_MATCH, nullptr);
+                return { false, "Update failed: " + error };
+            }
+        }
+        reply = call(conn, NM_PATH, NM_IFACE, "ActivateConnection", [&](DBusMessageIter* args) {
+            append_path(args, connpath);
+            append_path(args, device);
+            append_path(args, specific_object);
+        }, &error);
+    }
+
+    const std::string active_path = last_path_arg(reply.get());
+    if (active_path.empty()) {
+        dbus_bus_remove_match(conn, STATE_MATCH, nullptr);
+        return { false, "Activation failed: " + error };
+    }
+
+    // It may already be done if the profile was active before
+    uint32_t state = get_property(conn, active_path, ACTIVE_IFACE, "State").number;
+    uint32_t reason = 0;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    const auto token = CancellationToken::current();
+    while (state != ACTIVE_STATE_ACTIVATED && state != ACTIVE_STATE_DEACTIVATED && !token.cancelled()) {
+        while (Message msg{ dbus_connection_pop_message(conn) }) {
+            if (!dbus_message_is_signal(msg.get(), ACTIVE_IFACE, "StateChanged")) continue;
+            const char* path = dbus_message_get_path(msg.get());
+            if (!path || active_path != path) continue;
+
+            dbus_message_get_args(msg.get(), nullptr, DBUS_TYPE_UINT32, &state, DBUS_TYPE_UINT32, &reason,
+                                  DBUS_TYPE_INVALID);
+            if (state == ACTIVE_STATE_ACTIVATED || state == ACTIVE_STATE_DEACTIVATED) break;
+        }
+        if (state == ACTIVE_STATE_ACTIVATED || state == ACTIVE_STATE_DEACTIVATED) break;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+        left = std::min<long long>(left, CancellationToken::CHECK_INTERVAL.count());
+        if (!dbus_connection_read_write(conn, static_cast<int>(left))) break;
+    }
+    dbus_bus_remove_match(conn, STATE_MATCH, nullptr);
+
+    if (state == ACTIVE_STATE_ACTIVATED) return { true, "Activated" };
+    if (token.cancelled()) return { false, "Cancelled" };
+    if (state == ACTIVE_STATE_DEACTIVATED) return { false, "Activation failed (reason " + std::to_string(reason) + ")" };
+    return { false, "Timed out waiting for activation" };
+}
+
+bool NmDbus::delete_connection(std::string_view id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensure_connected()) return false;
+
+    std::string path = find_connection(connection_, id);
+    if (path.empty()) return false;
+    return call(connection_, path, CONNECTION_IFACE, "Delete") != nullptr;
+}
+
+bool NmDbus::deactivate(std::string_view id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ensure_connected()) return false;
+
+    for (const auto& active : get_property(connection_, NM_PATH, NM_IFACE, "ActiveConnections").list) {
+        if (get_property(connection_, active, ACTIVE_IFACE, "Id").text != id) continue;
+        return call(connection_, NM_PATH, NM_IFACE, "DeactivateConnection", [&](DBusMessageIter* args) {
+            append_path(args, active);
+        }) != nullptr;
+    }
+    return false;
+}
+
+#else
+
+NmDbus::NmDbus() {
+}
+
+NmDbus::~NmDbus() {
+}
+
+bool NmDbus::ensure_connected() {
+    return false;
+}
+
+bool NmDbus::available() {
+    return false;
+}
+
+std::optional<NmProfile> NmDbus::read_profile(std::string_view) {
+    return std::nullopt;
+}
+
+NmDbusResult NmDbus::activate(const NmProfile&, bool, int, std::string_view) {
+    return { false, "Built without D-Bus support" };
+}
+
+bool NmDbus::delete_connection(std::string_view) {
+    return false;
+}
+
+bool NmDbus::deactivate(std::string_view) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include "nm_profile.h"
+
+struct DBusConnection;
+
+struct NmDbusResult {
+    bool success;
+    std::string message;
+};
+
+// Talks to NetworkManager directly over the system D-Bus, so the Linux
+// connect path needs no nmcli processes or text parsing. Built only when
+// libdbus-1 is found (AUTOCONNECT_HAVE_DBUS); otherwise, or when the bus or
+// NetworkManager isn't reachable, available() is false and WiFiManager keeps
+// using nmcli. Short calls share one private bus connection behind a mutex.
+class NmDbus {
+public:
+    static NmDbus& instance();
+
+    bool available();
+
+    // Stored profile including its secrets (GetSettings + GetSecrets). The
+    // password reads empty without the rights to see it.
+    std::optional<NmProfile> read_profile(std::string_view id);
+
+    // Makes the stored profile match `profile` (Update in place when write is
+    // set, AddAndActivateConnection when none exists) and activates it on a
+    // WiFi device. Blocks on the active connection's StateChanged signals until
+    // it is activated, fails, or timeout_ms passes. Uses a connection of its
+    // own, so activations on different interfaces can wait in parallel.
+    // access_point (a BSSID) is preferred for this activation only, if the
+    // device can see it; it isn't written into the profile.
+    NmDbusResult activate(const NmProfile& profile, bool write, int timeout_ms, std::string_view access_point = {});
+
+    bool delete_connection(std::string_view id);
+    bool deactivate(std::string_view id);
+
+private:
+    NmDbus();
+    ~NmDbus();
+
+    std::mutex mutex_;
+    DBusConnection* connection_ = nullptr;
+
+    bool ensure_connected();
+};
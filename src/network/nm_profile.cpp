@@ -0,0 +1,146 @@
+#include "nm_profile.h"
+#include "../utils/system_utils.h"
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+// Read back in this order by read_from_nmcli
+static const char* NMCLI_FIELDS =
+    "connection.interface-name,802-11-wireless.ssid,802-1x.eap,802-1x.phase2-auth,"
+    "802-1x.identity,802-1x.anonymous-identity,802-11-wireless.bssid,802-1x.password";
+
+NmProfile NmProfile::for_method(std::string_view method, std::string_view id, std::string_view ssid,
+                                std::string_view identity, std::string_view password) {
+    NmProfile profile;
+    profile.id = std::string(id);
+    profile.ssid = std::string(ssid);
+    profile.identity = std::string(identity);
+    profile.password = std::string(password);
+
+    if (method == "ttls") {
+        profile.eap = "ttls";
+        profile.phase2_auth = "mschapv2";
+        profile.anonymous_identity = std::string(identity);
+    } else if (method == "peap") {
+        profile.eap = "peap";
+        profile.phase2_auth = "mschapv2";
+    } else {
+        profile.eap = "peap";
+        profile.phase2_auth = "md5";
+    }
+    return profile;
+}
+
+std::vector<std::string> NmProfile::nmcli_add_args() const {
+    std::vector<std::string> args = {
+        "connection", "add", "type", "wifi", "con-name", id,
+        "ifname", interface_name.empty() ? "*" : interface_name, "ssid", ssid,
+        "wifi-sec.key-mgmt", "wpa-eap", "802-1x.eap", eap, "802-1x.phase2-auth", phase2_auth,
+        "802-1x.identity", identity
+    };
+    if (!anonymous_identity.empty()) args.insert(args.end(), { "802-1x.anonymous-identity", anonymous_identity });
+    if (!bssid.empty()) args.insert(args.end(), { "802-11-wireless.bssid", bssid });
+    args.insert(args.end(), { "802-1x.password", password, "802-1x.system-ca-certs", "no",
+                              "802-1x.password-flags", "0", "connection.autoconnect", "yes" });
+    return args;
+}
+
+std::string NmProfile::fingerprint() const {
+    std::string canonical = "interface-name=" + interface_name + "\n"
+                            "ssid=" + ssid + "\n"
+                            "eap=" + eap + "\n"
+                            "phase2-auth=" + phase2_auth + "\n"
+                            "identity=" + identity + "\n"
+                            "anonymous-identity=" + anonymous_identity + "\n"
+                            "password=" + password + "\n";
+    // Only when set, so unpinned profiles keep the fingerprints they always had
+    if (!bssid.empty()) canonical += "bssid=" + bssid + "\n";
+    return SystemUtils::fingerprint(canonical);
+}
+
+// GKeyFile value escaping; list separators only matter for list values
+static std::string keyfile_escape(std::string_view value, bool list = false) {
+    std::string out;
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\r') out += "\\r";
+        else if (c == ' ' && i == 0) out += "\\s";
+        else if (c == ';' && list) out += "\\;";
+        else out += c;
+    }
+    return out;
+}
+
+std::string NmProfile::uuid() const {
+    std::string hex = SystemUtils::fingerprint("uuid:" + id + "\n" + ssid) + SystemUtils::fingerprint("ssid:" + ssid + "\n" + id);
+    hex[12] = '5';                                                  // name-based
+    hex[16] = "89ab"[std::stoi(hex.substr(16, 1), nullptr, 16) & 3]; // RFC 4122 variant
+    return hex.substr(0, 8) + "-" + hex.substr(8, 4) + "-" + hex.substr(12, 4) + "-" + hex.substr(16, 4) + "-" + hex.substr(20, 12);
+}
+
+std::string NmProfile::to_keyfile() const {
+    std::string out = "[connection]\n"
+                      "id=" + keyfile_escape(id) + "\n"
+                      "uuid=" + uuid() + "\n"
+                      "type=wifi\n";
+    if (!interface_name.empty()) out += "interface-name=" + keyfile_escape(interface_name) + "\n";
+    out += "autoconnect=true\n"
+           "\n[wifi]\n"
+           "mode=infrastructure\n"
+           "ssid=" + keyfile_escape(ssid) + "\n";
+    if (!bssid.empty()) out += "bssid=" + bssid + "\n";
+    out += "\n[wifi-security]\n"
+           "key-mgmt=wpa-eap\n"
+           "\n[802-1x]\n"
+           "eap=" + keyfile_escape(eap, true) + ";\n"
+           "identity=" + keyfile_escape(identity) + "\n";
+    if (!anonymous_identity.empty()) out += "anonymous-identity=" + keyfile_escape(anonymous_identity) + "\n";
+    out += "password=" + keyfile_escape(password) + "\n"
+           "password-flags=0\n"
+           "phase2-auth=" + keyfile_escape(phase2_auth) + "\n"
+           "system-ca-certs=false\n"
+           "\n[ipv4]\n"
+           "method=auto\n"
+           "\n[ipv6]\n"
+           "addr-gen-mode=default\n"
+           "method=auto\n";
+    return out;
+}
+
+std::optional<NmProfile> NmProfile::read_from_nmcli(std::string_view id) {
+    // -s so the stored password comes back too; without the rights for it the
+    // password reads empty, the fingerprint differs and we simply rewrite.
+    auto res = SystemUtils::run_command({ "nmcli", "-s", "-g", NMCLI_FIELDS, "connection", "show", std::string(id) }, 10);
+    if (!res.success) return std::nullopt;
+
+    std::vector<std::string> values;
+    std::istringstream lines(res.stdout_output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        // Terse output escapes ':' and '\'
+        std::string value;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] == '\\' && i + 1 < line.size() && (line[i + 1] == ':' || line[i + 1] == '\\')) ++i;
+            value += line[i];
+        }
+        values.push_back(value);
+    }
+    if (values.size() < 8) return std::nullopt;
+
+    NmProfile profile;
+    profile.id = std::string(id);
+    profile.interface_name = values[0];
+    profile.ssid = values[1];
+    profile.eap = values[2];
+    profile.phase2_auth = values[3];
+    profile.identity = values[4];
+    profile.anonymous_identity = values[5];
+    profile.bssid = values[6];
+    std::transform(profile.bssid.begin(), profile.bssid.end(), profile.bssid.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    profile.password = values[7];
+    return profile;
+}
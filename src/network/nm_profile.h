@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+// Desired state of the NetworkManager 802.1X WiFi connection. The connect
+// flow compares its fingerprint with what is already stored and only
+// rewrites the profile when something changed.
+struct NmProfile {
+    std::string id;
+    std::string ssid;
+    std::string interface_name;       // empty = any device
+    std::string bssid;                // stored 802-11-wireless.bssid (lower-case MAC); left empty by us, so an old pin is cleared
+    std::string eap;                  // peap / ttls
+    std::string phase2_auth;          // mschapv2 / md5
+    std::string identity;
+    std::string anonymous_identity;
+    std::string password;
+
+    // Builds the profile for one of the methods connect_linux tries: peap, ttls or peap-md5.
+    static NmProfile for_method(std::string_view method, std::string_view id, std::string_view ssid,
+                                std::string_view identity, std::string_view password);
+
+    // Arguments for `nmcli connection add ...`, without the leading "nmcli".
+    std::vector<std::string> nmcli_add_args() const;
+
+    // Hash over every setting and credential that matters for the connection.
+    std::string fingerprint() const;
+
+    // NetworkManager keyfile (.nmconnection) for this profile, secrets inline.
+    // The uuid is derived from id and ssid, so regenerating gives the same file.
+    std::string to_keyfile() const;
+    std::string uuid() const;
+
+    // Reads the stored profile back with `nmcli -s -g`. nullopt if it doesn't exist.
+    static std::optional<NmProfile> read_from_nmcli(std::string_view id);
+};
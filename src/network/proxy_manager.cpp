@@ -1,4 +1,6 @@
 #include "proxy_manager.h"
+#include "desktop_proxy.h"
+#include "../utils/metrics.h"
 #include <fstream>
 #include <vector>
 #include <filesystem>
@@ -15,6 +17,7 @@ const int ProxyManager::PROXY_PORT = 3128;
 const std::string ProxyManager::PAC_URL = "http://proxy02.uniswa.sz:3128/proxy.pac";
 
 ProxyResult ProxyManager::apply_settings() {
+    ScopedSpan span("proxy.apply");
     return enable_pac();
 }
 
@@ -67,12 +70,16 @@ ProxyResult ProxyManager::enable_pac() {
 }
 
 ProxyResult ProxyManager::enable_pac_linux(const std::string& pac_url) {
-    SystemUtils::run_command("gsettings set org.gnome.system.proxy mode 'auto'");
-    SystemUtils::run_command("gsettings set org.gnome.system.proxy autoconfig-url '" + pac_url + "'");
+    DesktopProxyBatch gnome(DesktopBackend::GNOME);
+    gnome.set("", "mode", DesktopProxyBatch::gvariant_string("auto"));
+    gnome.set("", "autoconfig-url", DesktopProxyBatch::gvariant_string(pac_url));
+    gnome.apply();
     
     // KDE
-    SystemUtils::run_command("kwriteconfig5 --file kioslaverc --group 'Proxy Settings' --key ProxyType 2");
-    SystemUtils::run_command("kwriteconfig5 --file kioslaverc --group 'Proxy Settings' --key proxyConfigScript '" + pac_url + "'");
+    DesktopProxyBatch kde(DesktopBackend::KDE);
+    kde.set("Proxy Settings", "ProxyType", "2");
+    kde.set("Proxy Settings", "proxyConfigScript", pac_url);
+    kde.apply();
 
     return { true, "Linux PAC enabled" };
 }
@@ -120,12 +127,23 @@ bool ProxyManager::is_configured() {
 #endif
 }
 
-ProxyResult ProxyManager::enable_linux_proxy() {
-    std::string url = "http://" + PROXY_HOST + ":" + std::to_string(PROXY_PORT);
+void ProxyManager::set_process_environment(bool enable) {
 #if !defined(_WIN32)
-    setenv("http_proxy", url.c_str(), 1);
-    setenv("https_proxy", url.c_str(), 1);
+    if (enable) {
+        std::string url = "http://" + PROXY_HOST + ":" + std::to_string(PROXY_PORT);
+        setenv("http_proxy", url.c_str(), 1);
+        setenv("https_proxy", url.c_str(), 1);
+    } else {
+        unsetenv("http_proxy");
+        unsetenv("https_proxy");
+    }
+#else
+    (void)enable;
 #endif
+}
+
+ProxyResult ProxyManager::enable_linux_proxy() {
+    set_process_environment(true);
     char* home = std::getenv("HOME");
     if (home) {
         std::string h(home);
@@ -138,10 +156,7 @@ ProxyResult ProxyManager::enable_linux_proxy() {
 }
 
 ProxyResult ProxyManager::disable_linux_proxy() {
-#if !defined(_WIN32)
-    unsetenv("http_proxy");
-    unsetenv("https_proxy");
-#endif
+    set_process_environment(false);
     char* home = std::getenv("HOME");
     if (home) {
         std::string h(home);
@@ -154,23 +169,27 @@ ProxyResult ProxyManager::disable_linux_proxy() {
 }
 
 void ProxyManager::configure_gsettings(bool enable) {
+    DesktopProxyBatch gnome(DesktopBackend::GNOME);
     if (enable) {
-        SystemUtils::run_command("gsettings set org.gnome.system.proxy mode 'manual'");
-        SystemUtils::run_command("gsettings set org.gnome.system.proxy.http host '" + PROXY_HOST + "'");
-        SystemUtils::run_command("gsettings set org.gnome.system.proxy.http port " + std::to_string(PROXY_PORT));
+        gnome.set("", "mode", DesktopProxyBatch::gvariant_string("manual"));
+        gnome.set("http", "host", DesktopProxyBatch::gvariant_string(PROXY_HOST));
+        gnome.set("http", "port", std::to_string(PROXY_PORT));
     } else {
-        SystemUtils::run_command("gsettings set org.gnome.system.proxy mode 'none'");
+        gnome.set("", "mode", DesktopProxyBatch::gvariant_string("none"));
     }
+    gnome.apply();
 }
 
 void ProxyManager::configure_kde(bool enable) {
+    DesktopProxyBatch kde(DesktopBackend::KDE);
     if (enable) {
         std::string url = "http://" + PROXY_HOST + ":" + std::to_string(PROXY_PORT);
-        SystemUtils::run_command("kwriteconfig5 --file kioslaverc --group 'Proxy Settings' --key ProxyType 1");
-        SystemUtils::run_command("kwriteconfig5 --file kioslaverc --group 'Proxy Settings' --key httpProxy '" + url + "'");
+        kde.set("Proxy Settings", "ProxyType", "1");
+        kde.set("Proxy Settings", "httpProxy", url);
     } else {
-        SystemUtils::run_command("kwriteconfig5 --file kioslaverc --group 'Proxy Settings' --key ProxyType 0");
+        kde.set("Proxy Settings", "ProxyType", "0");
     }
+    kde.apply();
 }
 
 bool ProxyManager::update_shell_file(std::string_view path, bool enable) {
@@ -11,6 +11,8 @@ struct ProxyResult {
 
 class ProxyManager {
 public:
+    // PAC setup through the desktop settings. Never touches this process's
+    // environment, so it may run alongside other threads.
     static ProxyResult apply_settings();
     static ProxyResult enable_pac();
     static ProxyResult enable_manual_proxy();
@@ -22,6 +24,9 @@ private:
     static const int PROXY_PORT;
     static const std::string PAC_URL;
 
+    // setenv/unsetenv of http_proxy and https_proxy. Not thread safe: nothing
+    // else may be spawning processes or reading the environment meanwhile.
+    static void set_process_environment(bool enable);
     static ProxyResult enable_linux_proxy();
     static ProxyResult disable_linux_proxy();
     static ProxyResult enable_pac_linux(const std::string& pac_url);
@@ -0,0 +1,93 @@
+#include "status_service.h"
+#include "link_monitor.h"
+#include "wifi_manager.h"
+#include "proxy_manager.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace {
+// How often a refresh() is noticed while waiting on link events
+constexpr std::chrono::milliseconds EVENT_SLICE{ 250 };
+// Connects and disconnects come as a burst of events; check once they stop
+constexpr std::chrono::milliseconds SETTLE{ 300 };
+constexpr int MAX_SETTLE_ROUNDS = 10;
+}
+
+StatusService::StatusService(Listener on_change) : on_change_(std::move(on_change)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+StatusService::~StatusService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.cancel();
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+StatusSnapshot StatusService::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_;
+}
+
+void StatusService::refresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_requested_ = true;
+    }
+    wake_.notify_all();
+}
+
+void StatusService::run() {
+    // Stopping cancels a check that is still waiting on a command
+    CancellationScope scope(stop_);
+    LinkMonitor monitor(true);
+    using Clock = std::chrono::steady_clock;
+
+    while (!stop_.cancelled()) {
+        StatusSnapshot next;
+        try {
+            next.wifi_connected = WiFiManager::is_connected();
+            next.proxy_configured = ProxyManager::is_configured();
+        } catch (...) {
+            LOG("Status check failed");
+        }
+        if (stop_.cancelled()) break;
+        next.ready = true;
+        next.taken = Clock::now();
+
+        bool changed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            changed = !snapshot_.ready || snapshot_.wifi_connected != next.wifi_connected ||
+                      snapshot_.proxy_configured != next.proxy_configured;
+            snapshot_ = next;
+        }
+        if (changed && on_change_) on_change_(next);
+
+        // Wait for a reason to look again
+        const auto until = Clock::now() + REFRESH_INTERVAL;
+        while (!stop_.cancelled()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(until - Clock::now());
+            if (left.count() <= 0) break;
+
+            if (monitor.available()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (refresh_requested_) break;
+                }
+                if (monitor.wait_for_event(std::min(left, EVENT_SLICE))) {
+                    for (int i = 0; i < MAX_SETTLE_ROUNDS && monitor.wait_for_event(SETTLE); ++i) {}
+                    break;
+                }
+            } else {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_for(lock, left, [this] { return refresh_requested_ || stop_.cancelled(); })) break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_requested_ = false;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "../utils/cancellation.h"
+
+struct StatusSnapshot {
+    bool ready = false; // False until the first check has finished
+    bool wifi_connected = false;
+    bool proxy_configured = false;
+    std::chrono::steady_clock::time_point taken;
+};
+
+// Keeps the connection status current on its own thread so the UI never has to
+// ask WiFiManager/ProxyManager (and wait on nmcli or netsh) itself. Re-checks on
+// link, address and route events where LinkMonitor works, every
+// REFRESH_INTERVAL otherwise, and whenever refresh() is called. on_change runs
+// on that thread after the first check and whenever the result changes.
+class StatusService {
+public:
+    using Listener = std::function<void(const StatusSnapshot&)>;
+
+    static constexpr std::chrono::seconds REFRESH_INTERVAL{ 15 };
+
+    explicit StatusService(Listener on_change);
+    ~StatusService();
+
+    StatusService(const StatusService&) = delete;
+    StatusService& operator=(const StatusService&) = delete;
+
+    // The last result; never blocks on a check.
+    StatusSnapshot snapshot() const;
+
+    // Asks for a check as soon as possible and returns straight away.
+    void refresh();
+
+private:
+    Listener on_change_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    StatusSnapshot snapshot_;
+    bool refresh_requested_ = false;
+    CancellationToken stop_;
+    std::thread thread_;
+
+    void run();
+};
@@ -1,15 +1,34 @@
 #include "wifi_manager.h"
+#include "link_monitor.h"
+#include "nl80211.h"
+#include "wifi_scan.h"
+#include "connection_history.h"
+#include "nm_profile.h"
+#include "nm_dbus.h"
 #include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/retry_scheduler.h"
+#include "../utils/cancellation.h"
 #include <fstream>
 #include <filesystem>
 #include <sstream>
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
 
 #if defined(_WIN32)
+#include <winsock2.h>
 #include <windows.h>
 #include <wlanapi.h>
+#include <iphlpapi.h>
+#include <cstdio>
 
 #ifndef WLAN_SET_EAPHOST_DATA_ALL_USERS
 #define WLAN_SET_EAPHOST_DATA_ALL_USERS 0x00000001
@@ -17,9 +36,35 @@
 
 #endif
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
 static const std::string WIFI_SSID = "uniswawifi-students";
 static const std::string PASSWORD_PREFIX = "Uneswa";
 
+static bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+// NetworkManager activates a profile on one device at a time, so parallel
+// attempts use one profile per radio
+static std::string linux_profile_id(std::string_view interface_name) {
+    return WIFI_SSID + "-" + std::string(interface_name);
+}
+
 std::string WiFiCredentials::normalize_birthday(std::string_view input) {
     std::string s(input);
     if (s.length() == 6) {
@@ -117,14 +162,14 @@ bool WiFiManager::set_eap_credentials(std::string_view ssid, std::string_view us
     DWORD v = 0;
     DWORD result = WlanOpenHandle(2, NULL, &v, &h);
     if (result != ERROR_SUCCESS) {
-        LOG("Failed to open WLAN handle: " + std::to_string(result));
+        LOG_ERROR("wifi", "Failed to open WLAN handle", {"error", result});
         return false;
     }
 
     PWLAN_INTERFACE_INFO_LIST l = NULL;
     result = WlanEnumInterfaces(h, NULL, &l);
     if (result != ERROR_SUCCESS) {
-        LOG("Failed to enumerate WLAN interfaces: " + std::to_string(result));
+        LOG_ERROR("wifi", "Failed to enumerate WLAN interfaces", {"error", result});
         WlanCloseHandle(h, NULL);
         return false;
     }
@@ -209,42 +254,237 @@ bool WiFiManager::set_eap_credentials(std::string_view ssid, std::string_view us
 #endif
 }
 
+// Being out of range shows up in the scan results long before an association
+// attempt times out. The cache answers the common case at once; when it lacks
+// our SSID (it may be stale after resume or a move, and a hidden SSID is only
+// found by a directed probe) a fresh scan for it decides. Only fresh data that
+// has networks but not ours counts as out of range; no data at all lets the
+// connect go ahead as before.
+static std::optional<WiFiResult> check_ssid_in_range() {
+    ScopedSpan span("wifi.scan");
+    auto report = WiFiScan::find(WIFI_SSID);
+    if (!report.visible()) report = WiFiScan::find(WIFI_SSID, true);
+    if (!report.known() || (!report.visible() && !report.fresh)) {
+        LOG("No fresh scan results for " + WIFI_SSID + ", skipping the range check");
+        return std::nullopt;
+    }
+    if (!report.visible()) {
+        LOG(WIFI_SSID + " " + report.describe());
+        return WiFiResult{ false, WIFI_SSID + " is not in range (" + std::to_string(report.networks_seen) +
+                                  " other networks visible). Move closer to an access point and try again." };
+    }
+    LOG(WIFI_SSID + " visible: " + report.describe());
+    return std::nullopt;
+}
+
+static std::atomic<bool> g_pin_strongest_ap{ false };
+
+void WiFiManager::set_pin_strongest_ap(bool enable) {
+    g_pin_strongest_ap = enable;
+}
+
+// The best ranked BSSID the profile's interface can see when pinning is on,
+// empty otherwise. Only passed to the activation, never stored in the profile:
+// a saved bssid would stop NetworkManager roaming and autoconnecting elsewhere.
+static std::string choose_access_point(const NmProfile& profile) {
+    if (!g_pin_strongest_ap) return "";
+
+    auto best = WiFiScan::best(WiFiScan::find(profile.ssid), profile.interface_name);
+    if (!best) return "";
+
+    std::string detail = std::to_string(best->bss.signal_mbm / 100) + " dBm, " + std::to_string(best->bss.frequency_mhz) + " MHz";
+    if (best->bss.channel_load >= 0) detail += ", " + std::to_string(best->bss.channel_load * 100 / 255) + "% busy";
+    LOG("Activating " + profile.id + " on " + best->bss.bssid + " (" + detail + ")");
+    return best->bss.bssid;
+}
+
 WiFiResult WiFiManager::connect(const WiFiCredentials& creds) {
+    ScopedSpan span("wifi.connect");
+    if (auto out_of_range = check_ssid_in_range()) return *out_of_range;
+
+    WiFiResult res{ false, "OS not supported for WiFi" };
     if (SystemUtils::get_os_type() == "Windows") {
-        return connect_win11_fixed(creds, creds.get_password());
+        res = connect_win11_fixed(creds, creds.get_password());
     } else if (SystemUtils::get_os_type() == "Linux") {
-        return connect_linux(creds, creds.get_password());
+        res = connect_linux(creds, creds.get_password());
+    }
+    // The attempts all report "timed out" once cancelled; say what really happened
+    if (!res.success && CancellationToken::current().cancelled()) return { false, "Cancelled" };
+    return res;
+}
+
+#if defined(_WIN32)
+static bool windows_profile_exists(std::string_view ssid) {
+    HANDLE h = NULL;
+    DWORD v = 0;
+    if (WlanOpenHandle(2, NULL, &v, &h) != ERROR_SUCCESS) return false;
+
+    bool found = false;
+    PWLAN_INTERFACE_INFO_LIST l = NULL;
+    if (WlanEnumInterfaces(h, NULL, &l) == ERROR_SUCCESS) {
+        std::wstring wssid(ssid.begin(), ssid.end());
+        for (DWORD i = 0; i < l->dwNumberOfItems && !found; i++) {
+            LPWSTR xml = NULL;
+            DWORD flags = 0;
+            if (WlanGetProfile(h, &l->InterfaceInfo[i].InterfaceGuid, wssid.c_str(), NULL, &xml, &flags, NULL) == ERROR_SUCCESS) {
+                found = true;
+                WlanFreeMemory(xml);
+            }
+        }
+        WlanFreeMemory(l);
+    }
+    WlanCloseHandle(h, NULL);
+    return found;
+}
+
+// True once the adapter behind a WLAN interface has a usable IPv4 address
+// (DHCP done; an APIPA 169.254.x.x fallback doesn't count)
+static bool windows_adapter_has_ipv4(const GUID& guid) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "{%08lX-%04hX-%04hX-%02X%02X-%02X%02X%02X%02X%02X%02X}",
+                  guid.Data1, guid.Data2, guid.Data3, guid.Data4[0], guid.Data4[1], guid.Data4[2],
+                  guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+
+    ULONG size = 16 * 1024;
+    std::vector<char> buffer;
+    ULONG res = ERROR_BUFFER_OVERFLOW;
+    for (int tries = 0; tries < 3 && res == ERROR_BUFFER_OVERFLOW; ++tries) {
+        buffer.resize(size);
+        res = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER,
+                                   NULL, reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()), &size);
+    }
+    if (res != NO_ERROR) return false;
+
+    for (auto* a = reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()); a; a = a->Next) {
+        if (_stricmp(a->AdapterName, name) != 0) continue;
+        if (a->OperStatus != IfOperStatusUp) return false;
+        for (auto* u = a->FirstUnicastAddress; u; u = u->Next) {
+            const auto* in = reinterpret_cast<const sockaddr_in*>(u->Address.lpSockaddr);
+            if (in->sin_family != AF_INET) continue;
+            const auto* octets = reinterpret_cast<const unsigned char*>(&in->sin_addr);
+            if (!(octets[0] == 169 && octets[1] == 254)) return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+// With more than one WLAN interface, asks all of them to connect with our
+// profile at once and keeps the first that is on our SSID with an address;
+// the rest are disconnected. nullopt when there's only one interface (netsh
+// path as usual).
+static std::optional<WiFiResult> connect_windows_all_interfaces(const Deadline& budget) {
+    HANDLE h = NULL;
+    DWORD v = 0;
+    if (WlanOpenHandle(2, NULL, &v, &h) != ERROR_SUCCESS) return std::nullopt;
+
+    std::vector<GUID> guids;
+    PWLAN_INTERFACE_INFO_LIST l = NULL;
+    if (WlanEnumInterfaces(h, NULL, &l) == ERROR_SUCCESS) {
+        for (DWORD i = 0; i < l->dwNumberOfItems; i++) guids.push_back(l->InterfaceInfo[i].InterfaceGuid);
+        WlanFreeMemory(l);
+    }
+    if (guids.size() < 2) {
+        WlanCloseHandle(h, NULL);
+        return std::nullopt;
     }
-    return { false, "OS not supported for WiFi" };
+
+    LOG_INFO("wifi", "Connecting on all WLAN interfaces", {"interfaces", guids.size()});
+    std::wstring profile(WIFI_SSID.begin(), WIFI_SSID.end());
+    std::vector<bool> started(guids.size(), false);
+    for (size_t i = 0; i < guids.size(); ++i) {
+        WLAN_CONNECTION_PARAMETERS params{};
+        params.wlanConnectionMode = wlan_connection_mode_profile;
+        params.strProfile = profile.c_str();
+        params.dot11BssType = dot11_BSS_type_infrastructure;
+        started[i] = WlanConnect(h, &guids[i], &params, NULL) == ERROR_SUCCESS;
+    }
+
+    // WlanConnect only queues the request; poll until one interface is on our
+    // SSID and its adapter has finished DHCP. Association alone isn't enough:
+    // the radio that associates first may still be the one that never gets an address.
+    int winner = -1;
+    RetryScheduler poll(RetryPhase::Association, &budget);
+    poll.run([&] {
+        for (size_t i = 0; i < guids.size() && winner < 0; ++i) {
+            if (!started[i]) continue;
+            PWLAN_CONNECTION_ATTRIBUTES conn = NULL;
+            DWORD size = 0;
+            if (WlanQueryInterface(h, &guids[i], wlan_intf_opcode_current_connection, NULL, &size,
+                                   (PVOID*)&conn, NULL) != ERROR_SUCCESS) continue;
+            const auto& ssid = conn->wlanAssociationAttributes.dot11Ssid;
+            bool associated = conn->isState == wlan_interface_state_connected &&
+                              std::string((const char*)ssid.ucSSID, ssid.uSSIDLength) == WIFI_SSID;
+            WlanFreeMemory(conn);
+            if (associated && windows_adapter_has_ipv4(guids[i])) winner = static_cast<int>(i);
+        }
+        return winner >= 0;
+    });
+
+    for (size_t i = 0; i < guids.size(); ++i) {
+        if (started[i] && static_cast<int>(i) != winner) WlanDisconnect(h, &guids[i], NULL);
+    }
+    WlanCloseHandle(h, NULL);
+
+    if (winner < 0) return WiFiResult{ false, "No interface got an address. Check ID/Birthday and signal." };
+    LOG_INFO("wifi", "Connected", {"interface", winner});
+    return WiFiResult{ true, "Connected to " + WIFI_SSID };
+}
+#else
+static bool windows_profile_exists(std::string_view) {
+    return false;
+}
+
+static std::optional<WiFiResult> connect_windows_all_interfaces(const Deadline&) {
+    return std::nullopt;
 }
+#endif
 
 WiFiResult WiFiManager::connect_win11_fixed(const WiFiCredentials& creds, std::string_view password) {
     LOG("Starting WiFi connection...");
 
-    SystemUtils::run_command("netsh wlan delete profile name=\"" + WIFI_SSID + "\"");
+    Deadline budget(RetryScheduler::policy(RetryPhase::WiFiConnect).deadline);
 
     std::string xml = create_profile_xml(WIFI_SSID, "", "");
-    auto temp = std::filesystem::temp_directory_path() / (WIFI_SSID + "_profile.xml");
+    std::string desired = SystemUtils::fingerprint(xml);
 
-    LOG("Dumping WiFi profile XML..");
-    {
-        std::ofstream out(temp);
-        out << xml;
-    }
+    // EAP user data is write-only, so compare against what we last wrote and only
+    // check that the profile is still there. Credentials are re-set either way;
+    // that's a single API call, not a profile rebuild.
+    if (windows_profile_exists(WIFI_SSID) && ConnectionHistory::instance().applied_fingerprint(WIFI_SSID) == desired) {
+        LOG("Profile unchanged, skipping rewrite");
+    } else {
+        ScopedSpan profile_span("wifi.profile_write");
+        SystemUtils::run_command("netsh wlan delete profile name=\"" + WIFI_SSID + "\"");
 
-    LOG("Adding profile to netsh");
-    auto res = SystemUtils::run_command("netsh wlan add profile filename=\"" + temp.string() + "\" user=all");
-    std::filesystem::remove(temp);
+        auto temp = std::filesystem::temp_directory_path() / (WIFI_SSID + "_profile.xml");
 
-    if (!res.success) {
-        return { false, "Failed to add profile: " + res.stdout_output };
-    }
+        LOG("Dumping WiFi profile XML..");
+        {
+            std::ofstream out(temp);
+            out << xml;
+        }
 
-    LOG("Profile added, waiting for propagation...");
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        LOG("Adding profile to netsh");
+        auto res = SystemUtils::run_command("netsh wlan add profile filename=\"" + temp.string() + "\" user=all");
+        std::filesystem::remove(temp);
+
+        if (!res.success) {
+            return { false, "Failed to add profile: " + res.error_text() };
+        }
+        ConnectionHistory::instance().set_applied_fingerprint(WIFI_SSID, desired);
+        profile_span.finish();
+
+        LOG("Profile added, waiting for propagation...");
+        RetryScheduler propagation(RetryPhase::ProfilePropagation, &budget);
+        propagation.run([] { return windows_profile_exists(WIFI_SSID); });
+    }
 
     LOG("Setting EAP credentials...");
-    if (!set_eap_credentials(WIFI_SSID, creds.student_id, password)) {
+    ScopedSpan credential_span("wifi.credential_set");
+    bool credentials_set = set_eap_credentials(WIFI_SSID, creds.student_id, password);
+    credential_span.finish();
+    if (!credentials_set) {
         LOG("ERROR: Failed to set EAP credentials via API - connection may require manual credential entry");
     } else {
         LOG("EAP credentials set successfully");
@@ -252,64 +492,217 @@ WiFiResult WiFiManager::connect_win11_fixed(const WiFiCredentials& creds, std::s
 
     LOG("Connecting to " + WIFI_SSID);
 
-    for (int i = 1; i <= 3; ++i) {
-        LOG("Attempt " + std::to_string(i) + " of 3...");
-        auto connect_res = SystemUtils::run_command("netsh wlan connect ssid=\"" + WIFI_SSID + "\" name=\"" + WIFI_SSID + "\"");
+    // Every interface already had its go, so the netsh loop below would only add its own attempt time
+    if (auto parallel = connect_windows_all_interfaces(budget)) return *parallel;
+
+    RetryScheduler retry(RetryPhase::ConnectAttempt, &budget);
+    for (int i = 1; i <= 3 && !budget.expired(); ++i) {
+        LOG_INFO("wifi", "Connect attempt", {"attempt", i}, {"of", 3});
+        ScopedSpan association_span("wifi.association");
+        auto connect_res = SystemUtils::run_command("netsh wlan connect ssid=\"" + WIFI_SSID + "\" name=\"" + WIFI_SSID + "\"",
+                                                    budget.remaining_seconds());
+        association_span.finish();
 
         if (connect_res.success) {
             LOG("In progress... waiting for DHCP etc.");
-            for (int s = 0; s < 30; ++s) {
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-                if (is_connected()) {
-                    LOG("Connected!");
-                    return { true, "Connected to " + WIFI_SSID };
-                }
-                if (s % 5 == 0 && s > 0) LOG("Wait... (" + std::to_string(s * 2) + "s)");
+            ScopedSpan ip_span("wifi.ip");
+            RetryScheduler poll(RetryPhase::Association, &budget);
+            if (poll.run([] { return is_connected(); })) {
+                LOG("Connected!");
+                return { true, "Connected to " + WIFI_SSID };
             }
         }
         if (i < 3) {
             LOG("Failed, retrying...");
-            std::this_thread::sleep_for(std::chrono::seconds(3));
+            if (!retry.pause()) break;
         }
     }
 
     return { false, "Couldn't connect. Check ID/Birthday and signal." };
 }
 
+WiFiResult WiFiManager::reconnect() {
+    if (auto out_of_range = check_ssid_in_range()) return *out_of_range;
+    if (SystemUtils::get_os_type() == "Windows") {
+        auto res = SystemUtils::run_command("netsh wlan connect ssid=\"" + WIFI_SSID + "\" name=\"" + WIFI_SSID + "\"");
+        if (!res.success) return { false, "Reconnect failed: " + res.error_text() };
+        Deadline budget(RetryScheduler::policy(RetryPhase::Association).deadline);
+        RetryScheduler poll(RetryPhase::Association, &budget);
+        if (poll.run([] { return is_connected(); })) return { true, "Reconnected to " + WIFI_SSID };
+        return { false, "Reconnect timed out" };
+    }
+
+    Deadline budget(RetryScheduler::policy(RetryPhase::WiFiConnect).deadline);
+    std::vector<std::string> ids = { WIFI_SSID };
+    for (const auto& iface : list_wireless_interfaces()) ids.push_back(linux_profile_id(iface));
+
+    // The stored profile is its own desired state, so this only activates
+    auto& nm = NmDbus::instance();
+    bool use_dbus = nm.available();
+    std::string last_error = "No saved profile";
+    for (const auto& id : ids) {
+        auto saved = use_dbus ? nm.read_profile(id) : NmProfile::read_from_nmcli(id);
+        if (!saved) continue;
+        // Drops a pin an older version saved into the profile
+        saved->bssid.clear();
+
+        LinkMonitor monitor;
+        auto res = activate_linux_profile(*saved, budget, choose_access_point(*saved));
+        if (res.success) res = wait_for_linux_ip(monitor, budget);
+        if (res.success) return { true, "Reconnected with " + id };
+        last_error = res.message;
+    }
+    return { false, last_error };
+}
+
 WiFiResult WiFiManager::disconnect() {
     if (SystemUtils::get_os_type() == "Windows") {
         auto res = SystemUtils::run_command("netsh wlan disconnect");
         if (res.success) return { true, "Disconnected" };
-        return { false, "Disconnect failed: " + res.stdout_output };
+        return { false, "Disconnect failed: " + res.error_text() };
     } else {
-        auto res = SystemUtils::run_command("nmcli connection down \"" + WIFI_SSID + "\"");
-        if (res.success) return { true, "Disconnected" };
-        return { false, "Disconnect failed: " + res.stdout_output };
+        bool any = deactivate_linux_connection(WIFI_SSID);
+        for (const auto& iface : list_wireless_interfaces()) {
+            any = deactivate_linux_connection(linux_profile_id(iface)) || any;
+        }
+        if (any) return { true, "Disconnected" };
+        return { false, "Disconnect failed: connection not active" };
     }
 }
 
+#if defined(__linux__)
+static bool interface_has_ipv4(const std::string& name) {
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) return false;
+    bool found = false;
+    for (ifaddrs* a = list; a; a = a->ifa_next) {
+        if (a->ifa_addr && a->ifa_addr->sa_family == AF_INET && name == a->ifa_name) {
+            found = true;
+            break;
+        }
+    }
+    freeifaddrs(list);
+    return found;
+}
+
+static bool interface_operstate_up(const std::string& name) {
+    std::ifstream in("/sys/class/net/" + name + "/operstate");
+    std::string state;
+    in >> state;
+    return state == "up";
+}
+#endif
+
 bool WiFiManager::is_connected() {
-    if (SystemUtils::get_os_type() == "Windows") {
-        auto res = SystemUtils::run_command("netsh wlan show interfaces");
-        if (res.success) {
-            std::string out = res.stdout_output;
-            for (auto& c : out) c = std::tolower(c);
-            bool connected = out.find("state") != std::string::npos && out.find("connected") != std::string::npos;
-            std::string ssid = WIFI_SSID;
-            for (auto& c : ssid) c = std::tolower(c);
-            return connected && out.find(ssid) != std::string::npos;
+    auto status = get_status();
+    return status.connected && status.has_ip && equals_ignore_case(status.ssid, WIFI_SSID);
+}
+
+WiFiStatus WiFiManager::get_status() {
+    WiFiStatus status{ false, false, "", "", "" };
+
+#if defined(_WIN32)
+    HANDLE h = NULL;
+    DWORD v = 0;
+    if (WlanOpenHandle(2, NULL, &v, &h) != ERROR_SUCCESS) return status;
+
+    PWLAN_INTERFACE_INFO_LIST l = NULL;
+    if (WlanEnumInterfaces(h, NULL, &l) == ERROR_SUCCESS) {
+        for (DWORD i = 0; i < l->dwNumberOfItems; i++) {
+            if (l->InterfaceInfo[i].isState != wlan_interface_state_connected) continue;
+
+            PWLAN_CONNECTION_ATTRIBUTES conn = NULL;
+            DWORD size = 0;
+            if (WlanQueryInterface(h, &l->InterfaceInfo[i].InterfaceGuid, wlan_intf_opcode_current_connection,
+                                   NULL, &size, (PVOID*)&conn, NULL) != ERROR_SUCCESS) continue;
+
+            const auto& assoc = conn->wlanAssociationAttributes;
+            std::string ssid((const char*)assoc.dot11Ssid.ucSSID, assoc.dot11Ssid.uSSIDLength);
+            if (status.ssid.empty() || equals_ignore_case(ssid, WIFI_SSID)) {
+                status.connected = true;
+                // The WLAN API has no view of DHCP; "connected" here is the same signal netsh used to give
+                status.has_ip = true;
+                status.ssid = ssid;
+                status.bssid = format_mac(assoc.dot11Bssid);
+                std::wstring desc(l->InterfaceInfo[i].strInterfaceDescription);
+                status.interface_name.clear();
+                for (wchar_t c : desc) status.interface_name += (c < 128) ? static_cast<char>(c) : '?';
+            }
+            WlanFreeMemory(conn);
         }
-    } else {
-        auto res = SystemUtils::run_command("nmcli -t -f NAME,TYPE,DEVICE connection show --active");
-        if (res.success) {
-            std::string out = res.stdout_output;
-            for (auto& c : out) c = std::tolower(c);
-            std::string ssid = WIFI_SSID;
-            for (auto& c : ssid) c = std::tolower(c);
-            return out.find("wifi") != std::string::npos && out.find(ssid) != std::string::npos;
+        WlanFreeMemory(l);
+    }
+    WlanCloseHandle(h, NULL);
+    return status;
+#else
+#if defined(__linux__)
+    auto& nl = Nl80211::instance();
+    if (nl.available()) {
+        // Prefer the interface on our SSID, otherwise report whatever is associated
+        WirelessInterface chosen{ 0, "", "" };
+        for (const auto& iface : nl.get_interfaces()) {
+            if (iface.ssid.empty()) continue;
+            if (chosen.ssid.empty() || equals_ignore_case(iface.ssid, WIFI_SSID)) chosen = iface;
+            if (equals_ignore_case(iface.ssid, WIFI_SSID)) break;
         }
+        if (chosen.index == 0) return status;
+
+        status.ssid = chosen.ssid;
+        status.interface_name = chosen.name;
+        status.connected = interface_operstate_up(chosen.name);
+        status.has_ip = interface_has_ipv4(chosen.name);
+        status.bssid = nl.get_station_bssid(chosen.index);
+        return status;
     }
-    return false;
+#endif
+    return get_status_nmcli();
+#endif
+}
+
+WiFiStatus WiFiManager::get_status_nmcli() {
+    WiFiStatus status{ false, false, "", "", "" };
+    auto res = SystemUtils::run_command({ "nmcli", "-t", "-f", "NAME,TYPE,DEVICE", "connection", "show", "--active" });
+    if (!res.success) return status;
+
+    std::istringstream lines(res.stdout_output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        // NAME:TYPE:DEVICE, with ':' inside names escaped as '\:'
+        size_t device_sep = line.rfind(':');
+        if (device_sep == std::string::npos || device_sep == 0) continue;
+        size_t type_sep = line.rfind(':', device_sep - 1);
+        if (type_sep == std::string::npos) continue;
+
+        std::string type = line.substr(type_sep + 1, device_sep - type_sep - 1);
+        if (type.find("wireless") == std::string::npos && type.find("wifi") == std::string::npos) continue;
+
+        std::string name;
+        for (size_t i = 0; i < type_sep; ++i) {
+            if (line[i] == '\\' && i + 1 < type_sep) ++i;
+            name += line[i];
+        }
+        std::string device = line.substr(device_sep + 1);
+
+        // The NAME is the profile's id, which for the per-interface profiles is
+        // "<ssid>-<device>"; ask for the SSID it actually carries
+        std::string ssid;
+        auto ssid_res = SystemUtils::run_command({ "nmcli", "-g", "802-11-wireless.ssid", "connection", "show", name });
+        if (ssid_res.success) {
+            ssid = ssid_res.stdout_output;
+            while (!ssid.empty() && (ssid.back() == '\n' || ssid.back() == '\r')) ssid.pop_back();
+        }
+        if (ssid.empty() && (equals_ignore_case(name, WIFI_SSID) || name == linux_profile_id(device))) ssid = WIFI_SSID;
+        if (ssid.empty()) ssid = name;
+
+        if (!status.ssid.empty() && !equals_ignore_case(ssid, WIFI_SSID)) continue;
+
+        status.connected = true;
+        status.has_ip = true;
+        status.ssid = ssid;
+        status.interface_name = device;
+        if (equals_ignore_case(ssid, WIFI_SSID)) break;
+    }
+    return status;
 }
 
 WiFiResult WiFiManager::remove_profile() {
@@ -317,58 +710,331 @@ WiFiResult WiFiManager::remove_profile() {
         SystemUtils::run_command("netsh wlan delete profile name=\"" + WIFI_SSID + "\"");
         return { true, "Profile removed" };
     } else {
-        if (remove_linux_connection(WIFI_SSID)) return { true, "Profile removed" };
+        bool removed = remove_linux_connection(WIFI_SSID);
+        for (const auto& iface : list_wireless_interfaces()) {
+            removed = remove_linux_connection(linux_profile_id(iface)) || removed;
+        }
+        if (removed) return { true, "Profile removed" };
         return { false, "Failed to remove profile" };
     }
 }
 
+std::vector<std::string> WiFiManager::list_wireless_interfaces() {
+    std::vector<std::string> names;
+#if defined(__linux__)
+    for (const auto& iface : Nl80211::instance().get_interfaces()) {
+        if (!iface.name.empty()) names.push_back(iface.name);
+    }
+    if (!names.empty()) return names;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/class/net", ec)) {
+        if (std::filesystem::exists(entry.path() / "wireless", ec)) names.push_back(entry.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+#endif
+    return names;
+}
+
 WiFiResult WiFiManager::connect_linux(const WiFiCredentials& creds, std::string_view password) {
-    remove_linux_connection(WIFI_SSID);
-    std::vector<std::string> methods = {"peap", "ttls", "peap-md5"};
+    // Try whatever worked last time on this radio first
+    auto interfaces = list_wireless_interfaces();
+    std::string primary = interfaces.empty() ? "" : interfaces.front();
+    std::vector<std::string> methods = ConnectionHistory::instance().order_methods(
+        WIFI_SSID, primary, {"peap", "ttls", "peap-md5"});
     std::string last_error;
 
-    for (const auto& method : methods) {
+    bool parallel = interfaces.size() > 1;
+    if (parallel) {
+        LOG_INFO("wifi", "Trying all wireless interfaces at once", {"interfaces", interfaces.size()});
+        // The generic profile would autoconnect against the per-interface ones
+        if (remove_linux_connection(WIFI_SSID)) LOG("Removed " + WIFI_SSID + " in favour of per-interface profiles");
+    } else if (!primary.empty() && remove_linux_connection(linux_profile_id(primary))) {
+        // And the other way round, once only one radio is left
+        LOG("Removed " + linux_profile_id(primary) + " in favour of " + WIFI_SSID);
+    }
+
+    // A failed parallel try means every radio ran the method and none got through
+    const std::vector<std::string> tried = parallel ? interfaces : std::vector<std::string>{ primary };
+
+    Deadline budget(RetryScheduler::policy(RetryPhase::WiFiConnect).deadline);
+    RetryScheduler method_switch(RetryPhase::MethodSwitch, &budget);
+
+    for (size_t m = 0; m < methods.size(); ++m) {
+        const std::string& method = methods[m];
+        if (m > 0 && !method_switch.pause()) {
+            last_error = "Timed out";
+            break;
+        }
         LOG("Trying " + method + "...");
-        auto res = try_linux_method(method, creds, password);
-        if (res.success) return res;
+        auto started = std::chrono::steady_clock::now();
+        auto res = parallel ? try_linux_method_parallel(method, interfaces, creds, password, budget)
+                            : try_linux_method(method, creds, password, budget);
+        long elapsed_ms = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count());
+
+        if (res.success) {
+            std::string iface = get_status().interface_name;
+            ConnectionHistory::instance().record(WIFI_SSID, iface.empty() ? primary : iface, method, true, elapsed_ms);
+            return res;
+        }
+        // Not if Cancel or the budget ended it; that would demote a method that works
+        for (const auto& iface : tried) {
+            ConnectionHistory::instance().record_failure(WIFI_SSID, iface, method, elapsed_ms, budget);
+        }
         last_error = res.message;
-        remove_linux_connection(WIFI_SSID);
-        std::this_thread::sleep_for(std::chrono::seconds(1));
     }
     return { false, "All methods failed. Last error: " + last_error };
 }
 
-WiFiResult WiFiManager::try_linux_method(std::string_view method, const WiFiCredentials& creds, std::string_view password) {
-    std::string nm_cmd;
-    std::string pwd(password);
-    if (method == "peap") {
-        nm_cmd = "nmcli connection add type wifi con-name \"" + WIFI_SSID + "\" ifname \"*\" ssid \"" + WIFI_SSID + "\" "
-                 "wifi-sec.key-mgmt wpa-eap 802-1x.eap peap 802-1x.phase2-auth mschapv2 "
-                 "802-1x.identity \"" + creds.student_id + "\" 802-1x.password \"" + pwd + "\" "
-                 "802-1x.system-ca-certs no 802-1x.password-flags 0 connection.autoconnect yes";
-    } else if (method == "ttls") {
-         nm_cmd = "nmcli connection add type wifi con-name \"" + WIFI_SSID + "\" ifname \"*\" ssid \"" + WIFI_SSID + "\" "
-                 "wifi-sec.key-mgmt wpa-eap 802-1x.eap ttls 802-1x.phase2-auth mschapv2 "
-                 "802-1x.identity \"" + creds.student_id + "\" 802-1x.anonymous-identity \"" + creds.student_id + "\" "
-                 "802-1x.password \"" + pwd + "\" 802-1x.system-ca-certs no 802-1x.password-flags 0 connection.autoconnect yes";
-    } else {
-        nm_cmd = "nmcli connection add type wifi con-name \"" + WIFI_SSID + "\" ifname \"*\" ssid \"" + WIFI_SSID + "\" "
-                 "wifi-sec.key-mgmt wpa-eap 802-1x.eap peap 802-1x.phase2-auth md5 "
-                 "802-1x.identity \"" + creds.student_id + "\" 802-1x.password \"" + pwd + "\" "
-                 "802-1x.system-ca-certs no 802-1x.password-flags 0 connection.autoconnect yes";
+WiFiResult WiFiManager::try_linux_method(std::string_view method, const WiFiCredentials& creds, std::string_view password,
+                                         const Deadline& budget) {
+    NmProfile desired = NmProfile::for_method(method, WIFI_SSID, WIFI_SSID, creds.student_id, password);
+
+    // Subscribe before activating so the carrier/address events can't slip past us
+    LinkMonitor monitor;
+    auto res = activate_linux_profile(desired, budget, choose_access_point(desired));
+    if (!res.success) return res;
+    return wait_for_linux_ip(monitor, budget);
+}
+
+WiFiResult WiFiManager::activate_linux_profile(const NmProfile& desired, const Deadline& budget,
+                                               std::string_view access_point) {
+    if (budget.expired()) return { false, "Timed out" };
+    auto activation_timeout = budget.capped(RetryScheduler::policy(RetryPhase::Activation).deadline);
+
+    // Talk to NetworkManager over D-Bus when we can, nmcli otherwise
+    auto& nm = NmDbus::instance();
+    bool use_dbus = nm.available();
+
+    // Leave a matching profile alone and go straight to activation; otherwise replace it
+    auto current = use_dbus ? nm.read_profile(desired.id) : NmProfile::read_from_nmcli(desired.id);
+    bool unchanged = current && current->fingerprint() == desired.fingerprint();
+    if (unchanged) LOG("Profile " + desired.id + " unchanged, activating");
+
+    if (use_dbus) {
+        ScopedSpan association_span("wifi.association");
+        auto act_res = nm.activate(desired, !unchanged, static_cast<int>(activation_timeout.count()), access_point);
+        if (!act_res.success) return { false, act_res.message };
+        return { true, "Activated" };
     }
 
-    auto res = SystemUtils::run_command(nm_cmd);
-    if (!res.success) return { false, "nmcli add failed: " + res.stdout_output };
+    if (!unchanged) {
+        ScopedSpan profile_span("wifi.profile_write");
+        if (current) remove_linux_connection(desired.id);
 
-    auto act_res = SystemUtils::run_command("nmcli connection up \"" + WIFI_SSID + "\"");
-    if (act_res.success) {
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-        if (is_connected()) return { true, "Connected" };
+        // Passed as argv straight to nmcli, so identities/passwords need no shell quoting.
+        std::vector<std::string> nm_cmd = desired.nmcli_add_args();
+        nm_cmd.insert(nm_cmd.begin(), "nmcli");
+        auto res = SystemUtils::run_command(nm_cmd);
+        if (!res.success) return { false, "nmcli add failed: " + res.error_text() };
     }
+
+    // NetworkManager only returns once DHCP is done too, so on Linux this span covers both
+    ScopedSpan association_span("wifi.association");
+    Deadline activation(activation_timeout);
+    std::vector<std::string> up_cmd = { "nmcli", "connection", "up", desired.id };
+    if (!access_point.empty()) up_cmd.insert(up_cmd.end(), { "ap", std::string(access_point) });
+    auto act_res = SystemUtils::run_command(up_cmd, activation.remaining_seconds());
+    if (!act_res.success) return { false, "Connection failed" };
+    return { true, "Activated" };
+}
+
+// True once iface is up, has an IPv4 address and (when nl80211 can tell) is on our SSID
+static bool linux_interface_connected(const std::string& iface) {
+#if defined(__linux__)
+    if (!interface_operstate_up(iface) || !interface_has_ipv4(iface)) return false;
+    auto& nl = Nl80211::instance();
+    if (!nl.available()) return true;
+    for (const auto& w : nl.get_interfaces()) {
+        if (w.name == iface) return equals_ignore_case(w.ssid, WIFI_SSID);
+    }
+    return false;
+#else
+    (void)iface;
+    return false;
+#endif
+}
+
+WiFiResult WiFiManager::try_linux_method_parallel(std::string_view method, const std::vector<std::string>& interfaces,
+                                                  const WiFiCredentials& creds, std::string_view password,
+                                                  const Deadline& budget) {
+    struct Attempt {
+        std::string iface;
+        NmProfile profile;
+        std::string access_point;
+        WiFiResult result;
+        bool done;
+    };
+    std::vector<Attempt> attempts;
+    for (const auto& iface : interfaces) {
+        NmProfile profile = NmProfile::for_method(method, linux_profile_id(iface), WIFI_SSID, creds.student_id, password);
+        profile.interface_name = iface;
+        std::string access_point = choose_access_point(profile);
+        attempts.push_back({ iface, std::move(profile), std::move(access_point), { false, "" }, false });
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::string winner;
+    size_t finished = 0;
+
+    std::vector<std::thread> threads;
+    const auto token = CancellationToken::current();
+    for (auto& attempt : attempts) {
+        threads.emplace_back([&, &attempt = attempt]() {
+            CancellationScope scope(token);
+            WiFiResult res{ false, "Skipped, another interface connected first" };
+            bool skip;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                skip = !winner.empty();
+            }
+            if (!skip) {
+                LinkMonitor monitor;
+                res = activate_linux_profile(attempt.profile, budget, attempt.access_point);
+                if (res.success) {
+                    RetryScheduler settle(RetryPhase::LinkSettle, &budget);
+                    RetryScheduler::Wait wait;
+                    if (monitor.available()) wait = [&](std::chrono::milliseconds d) { monitor.wait_for_event(d); };
+                    if (!settle.run([&] { return linux_interface_connected(attempt.iface); }, wait)) res = { false, "No address" };
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            attempt.result = res;
+            attempt.done = true;
+            if (res.success && winner.empty()) winner = attempt.iface;
+            finished++;
+            changed.notify_all();
+        });
+    }
+
+    // Once one radio has an address, cut the others short instead of waiting out
+    // their activation timeouts. Repeat until they've all returned, in case one
+    // was still writing its profile when it was first told to stop.
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return !winner.empty() || finished == attempts.size(); });
+    while (finished < attempts.size()) {
+        std::vector<std::string> pending;
+        for (const auto& attempt : attempts) {
+            if (!attempt.done && attempt.iface != winner) pending.push_back(attempt.profile.id);
+        }
+        lock.unlock();
+        for (const auto& id : pending) deactivate_linux_connection(id);
+        lock.lock();
+        changed.wait_for(lock, std::chrono::seconds(1), [&] { return finished == attempts.size(); });
+    }
+    lock.unlock();
+    for (auto& thread : threads) thread.join();
+
+    std::string errors;
+    for (const auto& attempt : attempts) {
+        if (attempt.iface == winner) continue;
+        if (!winner.empty()) {
+            deactivate_linux_connection(attempt.profile.id);
+            remove_linux_connection(attempt.profile.id);
+        }
+        errors += (errors.empty() ? "" : "; ") + attempt.iface + ": " + attempt.result.message;
+    }
+
+    if (winner.empty()) return { false, errors };
+    LOG("Connected on " + winner);
+    return { true, "Connected on " + winner };
+}
+
+WiFiResult WiFiManager::wait_for_linux_ip(LinkMonitor& monitor, const Deadline& budget) {
+    ScopedSpan ip_span("wifi.ip");
+
+    // Re-check on every link/address event, or on the backoff when netlink isn't available
+    RetryScheduler settle(RetryPhase::LinkSettle, &budget);
+    RetryScheduler::Wait wait;
+    if (monitor.available()) wait = [&](std::chrono::milliseconds d) { monitor.wait_for_event(d); };
+    if (settle.run([] { return is_connected(); }, wait)) return { true, "Connected" };
     return { false, "Connection failed" };
 }
 
+WiFiResult WiFiManager::write_linux_keyfile(std::string_view method, const WiFiCredentials& creds,
+                                            const std::string& root, bool* written) {
+    if (written) *written = false;
+    NmProfile profile = NmProfile::for_method(method, WIFI_SSID, WIFI_SSID, creds.student_id, creds.get_password());
+    std::string contents = profile.to_keyfile();
+
+    std::filesystem::path dir = std::filesystem::path(root) / "etc/NetworkManager/system-connections";
+    std::filesystem::path path = dir / (WIFI_SSID + ".nmconnection");
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) return { false, "Cannot create " + dir.string() + ": " + ec.message() };
+
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            std::ostringstream existing;
+            existing << in.rdbuf();
+            if (existing.str() == contents) {
+#if !defined(_WIN32)
+                // Same contents but maybe not the same mode (copied in, umask); NetworkManager
+                // skips keyfiles others can read, so put 0600 back either way
+                namespace fs = std::filesystem;
+                const auto owner_only = fs::perms::owner_read | fs::perms::owner_write;
+                auto status = fs::status(path, ec);
+                if (!ec && status.permissions() != owner_only) {
+                    fs::permissions(path, owner_only, fs::perm_options::replace, ec);
+                    if (ec) return { false, "Cannot chmod 0600 " + path.string() + ": " + ec.message() };
+                    return { true, path.string() + " unchanged, mode reset to 0600" };
+                }
+#endif
+                return { true, path.string() + " unchanged" };
+            }
+        }
+    }
+
+    std::string temp = path.string() + ".tmp";
+#if !defined(_WIN32)
+    // Created 0600 from the start; NetworkManager ignores keyfiles others can read
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return { false, "Cannot write " + temp + ": " + std::strerror(errno) };
+    fchmod(fd, 0600);
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t n = ::write(fd, contents.data() + done, contents.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    close(fd);
+    if (done != contents.size()) {
+        std::filesystem::remove(temp, ec);
+        return { false, "Short write to " + temp };
+    }
+#else
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << contents;
+        if (!out) return { false, "Cannot write " + temp };
+    }
+#endif
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return { false, "Cannot rename into " + path.string() };
+    }
+    if (written) *written = true;
+    return { true, path.string() + " written" };
+}
+
+bool WiFiManager::deactivate_linux_connection(std::string_view name) {
+    auto& nm = NmDbus::instance();
+    if (nm.available()) return nm.deactivate(name);
+    return SystemUtils::run_command({ "nmcli", "connection", "down", std::string(name) }).success;
+}
+
 bool WiFiManager::remove_linux_connection(std::string_view name) {
-    return SystemUtils::run_command("nmcli connection delete \"" + std::string(name) + "\"").success;
+    auto& nm = NmDbus::instance();
+    if (nm.available()) return nm.delete_connection(name);
+    return SystemUtils::run_command({ "nmcli", "connection", "delete", std::string(name) }).success;
 }
@@ -5,6 +5,10 @@
 #include <string_view>
 #include "../utils/system_utils.h"
 
+class LinkMonitor;
+class Deadline;
+struct NmProfile;
+
 struct WiFiCredentials {
     std::string student_id;
     std::string birthday;
@@ -19,13 +23,40 @@ struct WiFiResult {
     std::string message;
 };
 
+struct WiFiStatus {
+    bool connected;             // associated and operationally up
+    bool has_ip;                // has an IPv4 address
+    std::string ssid;
+    std::string interface_name;
+    std::string bssid;
+};
+
 class WiFiManager {
 public:
     static WiFiResult connect(const WiFiCredentials& creds);
     static WiFiResult disconnect();
     static bool is_connected();
+    static WiFiStatus get_status();
+    static std::vector<std::string> list_wireless_interfaces();
     static WiFiResult remove_profile();
 
+    // Re-activates the saved profile(s) without credentials, e.g. after the link
+    // dropped. Fails if nothing has been saved yet.
+    static WiFiResult reconnect();
+
+    // Optional: steer Linux activations to the best ranked access point for the
+    // SSID (signal, band, channel load; see WiFiScan::score). Re-ranked on every
+    // connect and reconnect and passed to that activation only, so the saved
+    // profile can still roam. Off by default.
+    static void set_pin_strongest_ap(bool enable);
+
+    // Offline alternative to connect_linux for image baking: writes the profile
+    // for method as <root>/etc/NetworkManager/system-connections/<ssid>.nmconnection
+    // (0600, atomic rename) without touching nmcli or a running NetworkManager.
+    // An identical existing file is only put back to 0600; `written` says which happened.
+    static WiFiResult write_linux_keyfile(std::string_view method, const WiFiCredentials& creds,
+                                          const std::string& root, bool* written = nullptr);
+
 private:
     static std::string create_profile_xml(std::string_view ssid, std::string_view serverName, std::string_view certThumbprint);
     static std::string create_user_xml(std::string_view username, std::string_view password);
@@ -33,6 +64,17 @@ private:
     static WiFiResult connect_win11_fixed(const WiFiCredentials& creds, std::string_view password);
     
     static WiFiResult connect_linux(const WiFiCredentials& creds, std::string_view password);
-    static WiFiResult try_linux_method(std::string_view method, const WiFiCredentials& creds, std::string_view password);
+    static WiFiResult try_linux_method(std::string_view method, const WiFiCredentials& creds, std::string_view password,
+                                       const Deadline& budget);
+    // Activates one profile per interface at once; the first to get an address is kept, the rest torn down.
+    static WiFiResult try_linux_method_parallel(std::string_view method, const std::vector<std::string>& interfaces,
+                                                const WiFiCredentials& creds, std::string_view password,
+                                                const Deadline& budget);
+    // access_point: BSSID to prefer for this activation, empty for any
+    static WiFiResult activate_linux_profile(const NmProfile& desired, const Deadline& budget,
+                                             std::string_view access_point = {});
+    static WiFiResult wait_for_linux_ip(LinkMonitor& monitor, const Deadline& budget);
+    static bool deactivate_linux_connection(std::string_view name);
     static bool remove_linux_connection(std::string_view name);
+    static WiFiStatus get_status_nmcli();
 };
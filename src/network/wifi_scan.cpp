@@ -0,0 +1,181 @@
+#include "wifi_scan.h"
+#include "../utils/retry_scheduler.h"
+#include "../utils/cancellation.h"
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <wlanapi.h>
+#endif
+
+// SSIDs are octet strings; "UniswaWiFi" is a different network, so no case folding
+static bool same_ssid(std::string_view a, std::string_view b) {
+    return a == b;
+}
+
+int ScanReport::best_signal_dbm() const {
+    return matches.empty() ? 0 : matches.front().bss.signal_mbm / 100;
+}
+
+std::string ScanReport::describe() const {
+    if (matches.empty()) return "not seen among " + std::to_string(networks_seen) + " networks";
+    const auto& best = matches.front();
+    std::string text = std::to_string(matches.size()) + (matches.size() == 1 ? " AP" : " APs") +
+                       ", strongest " + std::to_string(best_signal_dbm()) + " dBm (" + best.bss.bssid;
+    if (best.bss.frequency_mhz > 0) text += ", " + std::to_string(best.bss.frequency_mhz) + " MHz";
+    if (!best.interface_name.empty()) text += ", " + best.interface_name;
+    return text + ")";
+}
+
+// 5 GHz loses more through walls; below this a 2.4 GHz AP is usually the better link
+static const int HIGH_BAND_MIN_DBM = -70;
+static const int HIGH_BAND_BONUS_DB = 8;
+static const int BUSY_CHANNEL_PENALTY_DB = 15;
+
+int WiFiScan::score(const BssEntry& bss) {
+    int dbm = bss.signal_mbm / 100;
+    int score = dbm;
+    if (bss.frequency_mhz >= 4900 && dbm >= HIGH_BAND_MIN_DBM) score += HIGH_BAND_BONUS_DB;
+    if (bss.channel_load >= 0) score -= bss.channel_load * BUSY_CHANNEL_PENALTY_DB / 255;
+    return score;
+}
+
+std::optional<SsidSighting> WiFiScan::best(const ScanReport& report, std::string_view interface_name) {
+    const SsidSighting* chosen = nullptr;
+    for (const auto& sighting : report.matches) {
+        if (!interface_name.empty() && sighting.interface_name != interface_name) continue;
+        if (!chosen || score(sighting.bss) > score(chosen->bss)) chosen = &sighting;
+    }
+    if (!chosen) return std::nullopt;
+    return *chosen;
+}
+
+#if defined(_WIN32)
+
+namespace {
+
+    struct ScanWait {
+        GUID interface_guid;
+        HANDLE done;
+    };
+
+    void WINAPI on_wlan_notification(PWLAN_NOTIFICATION_DATA data, PVOID context) {
+        auto* wait = static_cast<ScanWait*>(context);
+        if (data->NotificationSource != WLAN_NOTIFICATION_SOURCE_ACM) return;
+        if (data->NotificationCode != wlan_notification_acm_scan_complete &&
+            data->NotificationCode != wlan_notification_acm_scan_fail) return;
+        if (IsEqualGUID(data->InterfaceGuid, wait->interface_guid)) SetEvent(wait->done);
+    }
+
+    std::string interface_label(const WLAN_INTERFACE_INFO& info) {
+        std::string name;
+        for (const wchar_t* c = info.strInterfaceDescription; *c; ++c) name += (*c < 128) ? static_cast<char>(*c) : '?';
+        return name;
+    }
+
+}
+
+ScanReport WiFiScan::find(std::string_view ssid, bool fresh_scan) {
+    ScanReport report{ std::string(ssid), 0, {}, false };
+
+    HANDLE h = NULL;
+    DWORD v = 0;
+    if (WlanOpenHandle(2, NULL, &v, &h) != ERROR_SUCCESS) return report;
+
+    PWLAN_INTERFACE_INFO_LIST l = NULL;
+    if (WlanEnumInterfaces(h, NULL, &l) != ERROR_SUCCESS) {
+        WlanCloseHandle(h, NULL);
+        return report;
+    }
+
+    DOT11_SSID dot11_ssid{};
+    dot11_ssid.uSSIDLength = static_cast<ULONG>(std::min<size_t>(ssid.size(), DOT11_SSID_MAX_LENGTH));
+    std::copy_n(ssid.begin(), dot11_ssid.uSSIDLength, dot11_ssid.ucSSID);
+
+    for (DWORD i = 0; i < l->dwNumberOfItems; i++) {
+        const auto& info = l->InterfaceInfo[i];
+
+        if (fresh_scan) {
+            // WlanScan only queues the scan; completion comes as an ACM notification
+            ScanWait wait{ info.InterfaceGuid, CreateEventW(NULL, TRUE, FALSE, NULL) };
+            if (wait.done && WlanRegisterNotification(h, WLAN_NOTIFICATION_SOURCE_ACM, TRUE, on_wlan_notification,
+                                                      &wait, NULL, NULL) == ERROR_SUCCESS) {
+                if (WlanScan(h, &info.InterfaceGuid, &dot11_ssid, NULL, NULL) == ERROR_SUCCESS) {
+                    auto timeout = RetryScheduler::policy(RetryPhase::FreshScan).deadline;
+                    if (WaitForSingleObject(wait.done, static_cast<DWORD>(timeout.count())) == WAIT_OBJECT_0) {
+                        report.fresh = true;
+                    }
+                }
+                WlanRegisterNotification(h, WLAN_NOTIFICATION_SOURCE_NONE, TRUE, NULL, NULL, NULL, NULL);
+            }
+            if (wait.done) CloseHandle(wait.done);
+        }
+
+        // NULL SSID: every BSS the service knows of, so we can tell "not in range" from "no data"
+        PWLAN_BSS_LIST bss_list = NULL;
+        if (WlanGetNetworkBssList(h, &info.InterfaceGuid, NULL, dot11_BSS_type_any, FALSE, NULL, &bss_list) != ERROR_SUCCESS) {
+            continue;
+        }
+        for (DWORD j = 0; j < bss_list->dwNumberOfItems; j++) {
+            const auto& entry = bss_list->wlanBssEntries[j];
+            report.networks_seen++;
+            std::string entry_ssid(reinterpret_cast<const char*>(entry.dot11Ssid.ucSSID), entry.dot11Ssid.uSSIDLength);
+            if (!same_ssid(entry_ssid, ssid)) continue;
+
+            const auto* ies = reinterpret_cast<const unsigned char*>(&entry) + entry.ulIeOffset;
+            BssEntry bss{ format_mac(entry.dot11Bssid), entry_ssid,
+                          static_cast<int>(entry.ulChCenterFrequency / 1000), static_cast<int>(entry.lRssi) * 100,
+                          info.isState == wlan_interface_state_connected, channel_load_from_ies(ies, entry.ulIeSize) };
+            report.matches.push_back({ interface_label(info), std::move(bss) });
+        }
+        WlanFreeMemory(bss_list);
+    }
+    WlanFreeMemory(l);
+    WlanCloseHandle(h, NULL);
+
+    std::stable_sort(report.matches.begin(), report.matches.end(), [](const SsidSighting& a, const SsidSighting& b) {
+        return a.bss.signal_mbm > b.bss.signal_mbm;
+    });
+    return report;
+}
+
+#else
+
+ScanReport WiFiScan::find(std::string_view ssid, bool fresh_scan) {
+    ScanReport report{ std::string(ssid), 0, {}, false };
+
+    auto& nl = Nl80211::instance();
+    if (!nl.available()) return report;
+    auto interfaces = nl.get_interfaces();
+
+    if (fresh_scan && !interfaces.empty()) {
+        // One scan per radio, side by side; each waits for its own completion event
+        int timeout_ms = static_cast<int>(RetryScheduler::policy(RetryPhase::FreshScan).deadline.count());
+        std::vector<std::thread> scans;
+        std::vector<char> finished(interfaces.size(), 0);
+        const auto token = CancellationToken::current();
+        for (size_t i = 0; i < interfaces.size(); ++i) {
+            scans.emplace_back([&, i] {
+                CancellationScope scope(token);
+                finished[i] = nl.trigger_scan(interfaces[i].index, ssid, timeout_ms) ? 1 : 0;
+            });
+        }
+        for (auto& scan : scans) scan.join();
+        report.fresh = std::find(finished.begin(), finished.end(), 1) != finished.end();
+    }
+
+    for (const auto& iface : interfaces) {
+        for (auto& bss : nl.get_scan_results(iface.index)) {
+            report.networks_seen++;
+            if (same_ssid(bss.ssid, ssid)) report.matches.push_back({ iface.name, std::move(bss) });
+        }
+    }
+
+    std::stable_sort(report.matches.begin(), report.matches.end(), [](const SsidSighting& a, const SsidSighting& b) {
+        return a.bss.signal_mbm > b.bss.signal_mbm;
+    });
+    return report;
+}
+
+#endif
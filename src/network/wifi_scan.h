@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <string_view>
+#include <optional>
+#include "nl80211.h"
+
+struct SsidSighting {
+    std::string interface_name;
+    BssEntry bss;
+};
+
+struct ScanReport {
+    std::string ssid;
+    int networks_seen;                  // BSSs in the scan data across all interfaces, any SSID
+    std::vector<SsidSighting> matches;  // BSSs broadcasting ssid, strongest first
+    bool fresh;                         // a new scan finished for this report
+
+    // No scan data at all, so visibility can't be judged either way
+    bool known() const { return networks_seen > 0; }
+    bool visible() const { return !matches.empty(); }
+    int best_signal_dbm() const;
+
+    // e.g. "3 APs, strongest -61 dBm (aa:bb:cc:dd:ee:ff, 5180 MHz, wlan0)"
+    std::string describe() const;
+};
+
+// Reads the scan results the OS already has (nl80211's BSS cache on Linux,
+// the WLAN service's BSS list on Windows) so the connect flow can tell in
+// well under a second whether the network is in range at all.
+class WiFiScan {
+public:
+    // With fresh_scan, asks every wireless interface for a new scan first and
+    // waits for it (RetryPhase::FreshScan deadline); if that isn't allowed or
+    // doesn't finish, the cached results are used.
+    static ScanReport find(std::string_view ssid, bool fresh_scan = false);
+
+    // Ranking score in dB-ish units: signal, plus a bonus for 5/6 GHz when the
+    // signal is good enough to use it, minus up to 15 for a busy channel.
+    static int score(const BssEntry& bss);
+
+    // Highest scoring sighting, limited to interface_name when given.
+    static std::optional<SsidSighting> best(const ScanReport& report, std::string_view interface_name = {});
+};
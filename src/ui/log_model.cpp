@@ -0,0 +1,40 @@
+#include "log_model.h"
+#include <algorithm>
+
+LogModel::LogModel(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+    entries_.reserve(capacity_);
+}
+
+void LogModel::append(std::vector<LogEntry> entries) {
+    // More than fit in one go: only the newest ones would survive anyway
+    size_t first = entries.size() > capacity_ ? entries.size() - capacity_ : 0;
+    size_t added = 0, dropped = 0;
+
+    for (size_t i = first; i < entries.size(); ++i) {
+        if (entries_.size() < capacity_) {
+            entries_.push_back(std::move(entries[i]));
+            added++;
+        } else {
+            entries_[head_] = std::move(entries[i]);
+            head_ = (head_ + 1) % capacity_;
+            dropped++;
+        }
+    }
+
+    if (dropped > 0) notify_row_removed(0, dropped);
+    if (added + dropped > 0) notify_row_added(entries_.size() - added - dropped, added + dropped);
+}
+
+void LogModel::rerender() {
+    // The view only fetches the rows it shows again
+    for (size_t row = 0; row < entries_.size(); ++row) notify_row_changed(row);
+}
+
+size_t LogModel::row_count() const {
+    return entries_.size();
+}
+
+std::optional<slint::SharedString> LogModel::row_data(size_t row) const {
+    if (row >= entries_.size()) return std::nullopt;
+    return slint::SharedString(Logger::render(entries_[(head_ + row) % entries_.size()]));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <slint.h>
+#include <vector>
+#include "../utils/logger.h"
+
+// Activity log entries for the ListView, kept in a fixed-size ring. Once full,
+// each new entry replaces the oldest one, so appending costs the same however
+// long the session runs. Entries are stored unrendered and only turned into
+// text for the rows the view asks for, in the current language. Only touch it
+// from the UI thread.
+class LogModel : public slint::Model<slint::SharedString> {
+public:
+    explicit LogModel(size_t capacity);
+
+    void append(std::vector<LogEntry> entries);
+
+    // Re-renders every row, e.g. after the language changed.
+    void rerender();
+
+    size_t row_count() const override;
+    std::optional<slint::SharedString> row_data(size_t row) const override;
+
+private:
+    std::vector<LogEntry> entries_;
+    size_t head_ = 0; // Oldest entry once the ring is full
+    size_t capacity_;
+};
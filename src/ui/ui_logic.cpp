@@ -1,54 +1,77 @@
 #include "ui_logic.h"
 #include "../utils/logger.h"
 #include "../utils/translations.h"
+#include "../utils/metrics.h"
+#include "../utils/task_graph.h"
 #include "../network/wifi_manager.h"
 #include "../network/proxy_manager.h"
 #include "../network/device_registry.h"
-#include <thread>
 #include <string_view> // const string& more or less.
 #include <mutex>
 #include <iostream>
-
-UILogic::UILogic(AppWindow* window) : app_window(window), is_working(false) {
-    Logger::instance().set_callback([this](std::string_view msg) {
-        this->on_log_message(msg);
+#include <cstdio>
+#include <cmath>
+
+UILogic::UILogic(AppWindow* window)
+    : app_window(window), log_model(std::make_shared<LogModel>(LOG_LINES)),
+      status_service([this](const StatusSnapshot& snapshot) {
+          slint::invoke_from_event_loop([this, snapshot]() { show_status(snapshot); });
+      }) {
+    if (app_window) app_window->set_log_lines(log_model);
+    Logger::instance().set_callback([this](const LogEntry& entry) {
+        this->on_log_message(entry);
     });
     update_ui_language();
 }
 
-void UILogic::on_log_message(std::string_view msg) {
-    std::string s(msg);
+UILogic::~UILogic() {
+    // The worker may log on its way out; don't route that back into us
+    Logger::instance().set_callback(nullptr);
+}
+
+void UILogic::on_log_message(const LogEntry& entry) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending_entries.push_back(entry);
+        if (flush_queued) return;
+        flush_queued = true;
+    }
 
     //WIndows keeps crsahing so I think using a weak reference approach will stop that...
     // yeah, that works, lol.
-    slint::invoke_from_event_loop([this, s]() {
-        std::lock_guard<std::mutex> lock(ui_mutex);
-        if (app_window) {
-            try {
-                std::string updated = std::string(app_window->get_log_text()) + s + "\n";
-                app_window->set_log_text(slint::SharedString(updated));
-            } catch (...) {
-                std::cerr << "UI update error at around line 23 in ui_lohivc.cpp in ui folder\n";
-                return;
-            }
-        }
-    });
+    slint::invoke_from_event_loop([this]() { flush_log(); });
+}
+
+void UILogic::flush_log() {
+    std::vector<LogEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        entries.swap(pending_entries);
+        flush_queued = false;
+    }
+
+    try {
+        log_model->append(std::move(entries));
+    } catch (...) {
+        std::cerr << "UI update error at around line 23 in ui_lohivc.cpp in ui folder\n";
+    }
 }
 
 void UILogic::update_status() {
+    status_service.refresh();
+}
+
+void UILogic::show_status(const StatusSnapshot& snapshot) {
     std::lock_guard<std::mutex> lock(ui_mutex);
-    if (!app_window) return;
+    if (!app_window || !snapshot.ready) return;
 
     try {
-        bool wifi_conn = WiFiManager::is_connected();
-        bool proxy_conf = ProxyManager::is_configured();
-
         AppStatus status;
-        status.wifi_connected = wifi_conn;
-        status.proxy_configured = proxy_conf;
+        status.wifi_connected = snapshot.wifi_connected;
+        status.proxy_configured = snapshot.proxy_configured;
 
-        if (wifi_conn && proxy_conf) status.overall_status = slint::SharedString(T("status_fully_connected"));
-        else if (wifi_conn) status.overall_status = slint::SharedString(T("status_partially_connected"));
+        if (snapshot.wifi_connected && snapshot.proxy_configured) status.overall_status = slint::SharedString(T("status_fully_connected"));
+        else if (snapshot.wifi_connected) status.overall_status = slint::SharedString(T("status_partially_connected"));
         else status.overall_status = slint::SharedString(T("status_not_connected"));
 
         app_window->set_status(status);
@@ -58,10 +81,12 @@ void UILogic::update_status() {
 }
 
 void UILogic::update_ui_language() {
-    std::lock_guard<std::mutex> lock(ui_mutex);
+    std::unique_lock<std::mutex> lock(ui_mutex);
     if (!app_window) return;
 
     try {
+        // The language may have been picked before the window existed (--lang, locale)
+        app_window->set_is_siswati(Translations::instance().get_language() == Language::SISWATI);
         app_window->set_app_title(slint::SharedString(T("app_title")));
         app_window->set_app_subtitle(slint::SharedString(T("app_subtitle")));
         app_window->set_student_credentials_text(slint::SharedString(T("student_credentials")));
@@ -90,7 +115,9 @@ void UILogic::update_ui_language() {
         app_window->set_siswati_text(slint::SharedString(T("siswati")));
         app_window->set_info_text(slint::SharedString("ℹ"));
 
-        update_status();
+        // The overall status is translated too; redraw it from the last snapshot
+        lock.unlock();
+        show_status(status_service.snapshot());
     } catch (...) {
         std::cerr << "UI update error at around line 23 in ui_lohivc.cpp in ui folder\n";
         return;
@@ -101,7 +128,9 @@ void UILogic::on_language_changed(bool is_siswati) {
     try {
         Translations::instance().set_language(is_siswati ? Language::SISWATI : Language::ENGLISH);
         update_ui_language();
-        LOG(T("language") + ": " + (is_siswati ? T("siswati") : T("english")));
+        // Log entries are kept unrendered; the visible ones come back in the new language
+        log_model->rerender();
+        LOG_INFO("ui", "{}: {}", {"label", TR_ID("language")}, {"language", is_siswati ? TR_ID("siswati") : TR_ID("english")});
     } catch (...) {
         std::cerr << "UI language error at around line 103 in ui_lohivc.cpp in ui folder\n";
         return;
@@ -110,10 +139,10 @@ void UILogic::on_language_changed(bool is_siswati) {
 
 void UILogic::on_info_clicked() {
     try {
-        LOG("=== " + T("info_title") + " ===");
-        LOG("📅 " + T("birthday_mode") + ": " + T("info_birthday_explanation"));
-        LOG("🔑 " + T("custom_password_mode") + ": " + T("info_password_explanation"));
-        LOG("💡 " + T("info_tip"));
+        LOG_INFO("ui", "=== {} ===", {"title", TR_ID("info_title")});
+        LOG_INFO("ui", "📅 {}: {}", {"mode", TR_ID("birthday_mode")}, {"explanation", TR_ID("info_birthday_explanation")});
+        LOG_INFO("ui", "🔑 {}: {}", {"mode", TR_ID("custom_password_mode")}, {"explanation", TR_ID("info_password_explanation")});
+        LOG_INFO("ui", "💡 {}", {"tip", TR_ID("info_tip")});
         LOG("===============================");
     } catch (...) {
         std::cerr << "UI update error at around line 110 in ui_lohivc.cpp in ui folder\n";
@@ -133,6 +162,30 @@ void UILogic::on_quit_app() {
     }
 }
 
+bool UILogic::run_action(std::function<void()> job, const char* error_message) {
+    bool expected = false;
+    if (!is_working.compare_exchange_strong(expected, true)) return false;
+    set_working_state(true);
+
+    // The worker is owned by this object and joined before it goes away, so `this` stays valid
+    workers.submit([this, job = std::move(job), error_message]() {
+        try {
+            job();
+        } catch (...) {
+            LOG(error_message);
+        }
+        update_status();
+
+        is_working = false;
+        set_working_state(false);
+    });
+    return true;
+}
+
+void UILogic::cancel_work() {
+    workers.cancel_all();
+}
+
 void UILogic::complete_setup() {
     if (is_working) return;
 
@@ -153,45 +206,53 @@ void UILogic::complete_setup() {
     }
 
     if (sid.empty() || bday_or_pass.empty()) {
-        LOG(T("credentials_required"));
+        LOG_TR(LogLevel::Warn, "ui", "credentials_required");
         return;
     }
 
-    is_working = true;
-    set_working_state(true);
-
-    // Logic object needs to stay alive during te thread execution
-    auto self = shared_from_this();
-    std::thread([self, sid, bday_or_pass, use_custom]() {
-        try {
-            LOG(T("starting_setup"));
-            LOG(T("setup_time_warning"));
-
-            WiFiCredentials creds;
-            creds.student_id = sid;
-            if (use_custom) creds.custom_password = bday_or_pass;
-            else creds.birthday = bday_or_pass;
-
-            WiFiResult wifi_res = WiFiManager::connect(creds);
-            LOG(std::string(T(wifi_res.success ? "wifi_success" : "wifi_error")) + wifi_res.message);
-
-            RegistrationResult reg_res = DeviceRegistry::register_device(sid, creds.get_password());
-            LOG(std::string(T(reg_res.success ? "registration_success" : "registration_error")) + reg_res.message);
-
-            ProxyResult proxy_res = ProxyManager::apply_settings();
-            LOG(std::string(T(proxy_res.success ? "proxy_success" : "proxy_error")) + proxy_res.message);
-
-            if (wifi_res.success && proxy_res.success) LOG("\n" + T("setup_completed_success"));
-            else LOG("\n" + T("setup_completed_issues"));
-
-            self->update_status();
-        } catch (...) {
-            LOG("Error during setup");
-        }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+    run_action([sid, bday_or_pass, use_custom]() {
+        LOG_TR(LogLevel::Info, "ui", "starting_setup");
+        LOG_TR(LogLevel::Info, "ui", "setup_time_warning");
+        ScopedSpan setup_span("setup.complete");
+
+        WiFiCredentials creds;
+        creds.student_id = sid;
+        if (use_custom) creds.custom_password = bday_or_pass;
+        else creds.birthday = bday_or_pass;
+
+        // The proxy doesn't need the link, so it runs alongside the WiFi connect;
+        // registration goes as soon as connect returns (with an address, if it worked).
+        // apply_settings leaves the process environment alone, so this can't race
+        // with connect spawning nmcli, and registration goes direct regardless.
+        TaskGraph setup;
+        size_t wifi = setup.add("wifi", [creds] {
+            WiFiResult res = WiFiManager::connect(creds);
+            return TaskResult{ res.success, res.message };
+        });
+        setup.add("registration", [sid, creds] {
+            RegistrationResult res = DeviceRegistry::register_device(sid, creds.get_password());
+            return TaskResult{ res.success, res.message };
+        }, { wifi });
+        size_t proxy = setup.add("proxy", [] {
+            ProxyResult res = ProxyManager::apply_settings();
+            return TaskResult{ res.success, res.message };
+        });
+
+        auto outcomes = setup.run([](const TaskOutcome& outcome) {
+            bool ok = outcome.result.success;
+            TextId text = ok ? TR_ID("proxy_success") : TR_ID("proxy_error");
+            if (outcome.name == "wifi") text = ok ? TR_ID("wifi_success") : TR_ID("wifi_error");
+            else if (outcome.name == "registration") text = ok ? TR_ID("registration_success") : TR_ID("registration_error");
+            LOG_AT(ok ? LogLevel::Info : LogLevel::Warn, "setup", text, {"detail", outcome.result.message},
+                   {"elapsed_s", std::round(outcome.elapsed_ms / 100.0) / 10.0});
+        });
+
+        if (outcomes[wifi].result.success && outcomes[proxy].result.success) LOG_TR(LogLevel::Info, "setup", "setup_completed_success");
+        else LOG_TR(LogLevel::Info, "setup", "setup_completed_issues");
+
+        setup_span.finish();
+        Metrics::instance().write_summary();
+    }, "Error during setup");
 }
 
 void UILogic::wifi_only() {
@@ -214,49 +275,23 @@ void UILogic::wifi_only() {
     }
 
     if (sid.empty() || bday_or_pass.empty()) {
-        LOG(T("credentials_required"));
+        LOG_TR(LogLevel::Warn, "ui", "credentials_required");
         return;
     }
 
-    is_working = true;
-    set_working_state(true);
-
-    auto self = shared_from_this();
-    std::thread([self, sid, bday_or_pass, use_custom]() {
-        try {
-            WiFiCredentials creds;
-            creds.student_id = sid;
-            if (use_custom) creds.custom_password = bday_or_pass;
-            else creds.birthday = bday_or_pass;
-            LOG(WiFiManager::connect(creds).message);
-            self->update_status();
-        } catch (...) {
-            LOG("Error during WiFi setup");
-        }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+    run_action([sid, bday_or_pass, use_custom]() {
+        WiFiCredentials creds;
+        creds.student_id = sid;
+        if (use_custom) creds.custom_password = bday_or_pass;
+        else creds.birthday = bday_or_pass;
+        LOG(WiFiManager::connect(creds).message);
+    }, "Error during WiFi setup");
 }
 
 void UILogic::proxy_only() {
-    if (is_working) return;
-
-    is_working = true;
-    set_working_state(true);
-
-    auto self = shared_from_this();
-    std::thread([self]() {
-        try {
-            LOG(ProxyManager::apply_settings().message);
-            self->update_status();
-        } catch (...) {
-            LOG("Error during proxy setup");
-        }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+    run_action([]() {
+        LOG(ProxyManager::apply_settings().message);
+    }, "Error during proxy setup");
 }
 
 void UILogic::register_device() {
@@ -280,73 +315,39 @@ void UILogic::register_device() {
 
     if (sid.empty() || bday_or_pass.empty()) return;
 
-    is_working = true;
-    set_working_state(true);
-
-    auto self = shared_from_this();
-    std::thread([self, sid, bday_or_pass, use_custom]() {
-        try {
-            WiFiCredentials creds;
-            creds.student_id = sid;
-            if (use_custom) creds.custom_password = bday_or_pass;
-            else creds.birthday = bday_or_pass;
-            LOG(DeviceRegistry::register_device(sid, creds.get_password()).message);
-            self->update_status();
-        } catch (...) {
-            LOG("Error during device registration");
-        }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+    run_action([sid, bday_or_pass, use_custom]() {
+        WiFiCredentials creds;
+        creds.student_id = sid;
+        if (use_custom) creds.custom_password = bday_or_pass;
+        else creds.birthday = bday_or_pass;
+        LOG(DeviceRegistry::register_device(sid, creds.get_password()).message);
+    }, "Error during device registration");
 }
 
 void UILogic::test_connection() {
-    if (is_working) return;
-
-    is_working = true;
-    set_working_state(true);
-
-    auto self = shared_from_this();
-    std::thread([self]() {
-        try {
-            LOG(T("testing_connection"));
-            bool wifi = WiFiManager::is_connected();
-            bool proxy = ProxyManager::is_configured();
-            if (wifi && proxy) LOG(T("connection_all_operational"));
-            else if (wifi) LOG(T("connection_wifi_only"));
-            else LOG(T("connection_not_connected"));
-            self->update_status();
-        } catch (...) {
-            LOG("Error during connection test");
+    run_action([]() {
+        LOG_TR(LogLevel::Info, "ui", "testing_connection");
+        WiFiStatus wifi_status = WiFiManager::get_status();
+        if (!wifi_status.interface_name.empty()) {
+            LOG("  " + wifi_status.ssid + " @ " + wifi_status.interface_name +
+                (wifi_status.bssid.empty() ? "" : " (" + wifi_status.bssid + ")") +
+                (wifi_status.has_ip ? "" : " - no IP"));
         }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+        bool wifi = WiFiManager::is_connected();
+        bool proxy = ProxyManager::is_configured();
+        if (wifi && proxy) LOG_TR(LogLevel::Info, "ui", "connection_all_operational");
+        else if (wifi) LOG_TR(LogLevel::Info, "ui", "connection_wifi_only");
+        else LOG_TR(LogLevel::Info, "ui", "connection_not_connected");
+    }, "Error during connection test");
 }
 
 void UILogic::reset_all() {
-    if (is_working) return;
-
-    is_working = true;
-    set_working_state(true);
-
-    auto self = shared_from_this();
-    std::thread([self]() {
-        try {
-            LOG(T("resetting_settings"));
-            LOG(WiFiManager::remove_profile().message);
-            LOG(ProxyManager::disable_proxy().message);
-            LOG(T("reset_complete"));
-            self->update_status();
-        } catch (...) {
-            LOG("Error during reset");
-        }
-
-        self->is_working = false;
-        self->set_working_state(false);
-    }).detach();
+    run_action([]() {
+        LOG_TR(LogLevel::Info, "ui", "resetting_settings");
+        LOG(WiFiManager::remove_profile().message);
+        LOG(ProxyManager::disable_proxy().message);
+        LOG_TR(LogLevel::Info, "ui", "reset_complete");
+    }, "Error during reset");
 }
 
 void UILogic::set_working_state(bool working) {
@@ -5,10 +5,17 @@
 #include <string_view>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "log_model.h"
+#include "../network/status_service.h"
+#include "../utils/worker_pool.h"
 
 class UILogic : public std::enable_shared_from_this<UILogic> {
 public:
     UILogic(AppWindow* window);
+    ~UILogic();
     
     void complete_setup();
     void wifi_only();
@@ -22,13 +29,40 @@ public:
     void on_info_clicked();
     void on_quit_app();
     
+    // Asks the status service for a fresh check; never blocks. The result
+    // reaches the window through show_status.
     void update_status();
+
+    // Cancels the running action (and anything queued); its connect and wait
+    // loops return within a few milliseconds.
+    void cancel_work();
     
 private:
     AppWindow* app_window;
-    bool is_working;
+    std::atomic<bool> is_working{ false };
     std::mutex ui_mutex;
+
+    // Most lines the activity log keeps before dropping the oldest
+    static constexpr size_t LOG_LINES = 5000;
+    std::shared_ptr<LogModel> log_model;
+
+    // Entries logged since the last flush. Only one flush is queued on the event
+    // loop at a time, so a burst of lines lands in the view in one go.
+    std::mutex pending_mutex;
+    std::vector<LogEntry> pending_entries;
+    bool flush_queued = false;
     
-    void on_log_message(std::string_view msg);
+    void on_log_message(const LogEntry& entry);
+    void flush_log();
+    void show_status(const StatusSnapshot& snapshot);
     void set_working_state(bool working);
+
+    // Claims the busy state and queues job on the worker; false if an action is already running
+    bool run_action(std::function<void()> job, const char* error_message);
+
+    // Before workers: jobs ask it for a refresh when they finish
+    StatusService status_service;
+
+    // Declared last so it is destroyed first: cancels and joins the worker while the rest is still alive
+    WorkerPool workers{ 1 };
 };
@@ -0,0 +1,54 @@
+#include "cancellation.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+struct CancellationToken::State {
+    std::atomic<bool> cancelled{ false };
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+namespace {
+
+    // Threads that never ran cancellable work share this one
+    const CancellationToken& never_cancelled() {
+        static const CancellationToken token;
+        return token;
+    }
+
+    thread_local CancellationToken t_current = never_cancelled();
+
+}
+
+CancellationToken::CancellationToken() : state_(std::make_shared<State>()) {
+}
+
+void CancellationToken::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->cancelled = true;
+    }
+    state_->changed.notify_all();
+}
+
+bool CancellationToken::cancelled() const {
+    return state_->cancelled;
+}
+
+bool CancellationToken::wait_for(std::chrono::milliseconds duration) const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    return state_->changed.wait_for(lock, duration, [this] { return state_->cancelled.load(); });
+}
+
+CancellationToken CancellationToken::current() {
+    return t_current;
+}
+
+CancellationScope::CancellationScope(CancellationToken token) : previous_(t_current) {
+    t_current = std::move(token);
+}
+
+CancellationScope::~CancellationScope() {
+    t_current = std::move(previous_);
+}
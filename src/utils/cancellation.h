@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+// Cooperative cancellation. Whoever starts a piece of work keeps a copy of the
+// token (copies share state) and the loops doing the work check it or sleep on
+// it. Work picks up the token of the thread it runs on through current(), so
+// long call chains don't have to pass one along; threads started for the work
+// install it again with CancellationScope.
+class CancellationToken {
+public:
+    CancellationToken();
+
+    // Longest a blocking wait (poll, D-Bus read) should go without checking cancelled()
+    static constexpr std::chrono::milliseconds CHECK_INTERVAL{ 50 };
+
+    void cancel();
+    bool cancelled() const;
+
+    // Sleeps up to duration. Returns true, early if need be, once cancelled.
+    bool wait_for(std::chrono::milliseconds duration) const;
+
+    // Both copies of the same token
+    bool same_as(const CancellationToken& other) const { return state_ == other.state_; }
+
+    // The token installed on this thread; one nobody cancels if there is none.
+    static CancellationToken current();
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+// Installs token as this thread's current one for the scope's lifetime.
+class CancellationScope {
+public:
+    explicit CancellationScope(CancellationToken token);
+    ~CancellationScope();
+
+    CancellationScope(const CancellationScope&) = delete;
+    CancellationScope& operator=(const CancellationScope&) = delete;
+
+private:
+    CancellationToken previous_;
+};
@@ -0,0 +1,71 @@
+#include "log_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+LogRing::LogRing(size_t arena_bytes, size_t max_lines)
+    : arena_(std::max<size_t>(arena_bytes, 1)), entries_(std::max<size_t>(max_lines, 1)) {
+}
+
+void LogRing::drop_oldest() {
+    first_ = (first_ + 1) % entries_.size();
+    count_--;
+    first_seq_++;
+}
+
+uint64_t LogRing::append(std::string_view line) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    const size_t length = std::min(line.size(), arena_.size());
+    // Lines never wrap around the end of the arena; start again from the front.
+    // Whatever still sits past write_pos_ is the oldest and goes with the tail.
+    if (write_pos_ + length > arena_.size() || write_pos_ == arena_.size()) {
+        while (count_ > 0 && entries_[first_].offset >= write_pos_) drop_oldest();
+        write_pos_ = 0;
+    }
+
+    // Live lines sit in arena order from the oldest up to write_pos_, so the
+    // ones in the way are always the oldest
+    while (count_ > 0) {
+        const Entry& oldest = entries_[first_];
+        bool overlaps = oldest.offset < write_pos_ + length &&
+                        write_pos_ < oldest.offset + std::max<size_t>(oldest.length, 1);
+        if (!overlaps && count_ < entries_.size()) break;
+        drop_oldest();
+    }
+
+    std::memcpy(arena_.data() + write_pos_, line.data(), length);
+    entries_[(first_ + count_) % entries_.size()] = { write_pos_, length };
+    count_++;
+    write_pos_ += length;
+    return first_seq_ + count_ - 1;
+}
+
+uint64_t LogRing::for_each_since(uint64_t since, const Visitor& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    const uint64_t end = first_seq_ + count_;
+    for (uint64_t seq = std::max(since, first_seq_); seq < end; ++seq) {
+        const Entry& entry = entries_[(first_ + (seq - first_seq_)) % entries_.size()];
+        visit(seq, std::string_view(arena_.data() + entry.offset, entry.length));
+    }
+    return end;
+}
+
+uint64_t LogRing::next_seq() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return first_seq_ + count_;
+}
+
+size_t LogRing::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return count_;
+}
+
+void LogRing::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    first_seq_ += count_;
+    first_ = 0;
+    count_ = 0;
+    write_pos_ = 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+// The most recent log lines, kept in one fixed-size byte arena plus a fixed
+// table of entries, so memory stays flat however long the app runs. A new line
+// overwrites the oldest ones it needs room from. Every line gets a sequence
+// number that keeps counting across evictions and clear(), so readers can
+// pick up where they left off.
+class LogRing {
+public:
+    // Lines longer than arena_bytes are cut to fit.
+    LogRing(size_t arena_bytes, size_t max_lines);
+
+    // Returns the line's sequence number.
+    uint64_t append(std::string_view line);
+
+    // Calls visit(seq, line) for each retained line numbered `since` or later,
+    // oldest first. Appends wait until it returns, so the views (which point
+    // into the arena) are a consistent snapshot; don't keep them past the call.
+    // Returns the sequence number to pass next time.
+    using Visitor = std::function<void(uint64_t seq, std::string_view line)>;
+    uint64_t for_each_since(uint64_t since, const Visitor& visit) const;
+
+    // Sequence number the next append will get.
+    uint64_t next_seq() const;
+
+    size_t size() const;
+    void clear();
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t length;
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::vector<char> arena_;
+    std::vector<Entry> entries_; // Ring: entries_[(first_ + i) % max] is line first_seq_ + i
+    size_t first_ = 0;
+    size_t count_ = 0;
+    uint64_t first_seq_ = 0;
+    size_t write_pos_ = 0;
+
+    void drop_oldest();
+};
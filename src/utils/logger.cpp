@@ -1,9 +1,312 @@
 #include "logger.h"
 #include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
 #include <filesystem>
+#include <cmath>
+#include <cstring>
+#if defined(AUTOCONNECT_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+std::terminate_handler g_previous_terminate = nullptr;
+
+const char* LOG_PATH = "logs/autoconnect.log";
+#if defined(AUTOCONNECT_HAVE_ZLIB)
+// A rotated slot is .N.gz, or plain .N when gzip failed
+const char* const ROTATED_SUFFIXES[] = { ".gz", "" };
+#else
+const char* const ROTATED_SUFFIXES[] = { "" };
+#endif
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warn: return "warn";
+    case LogLevel::Error: return "error";
+    }
+    return "info";
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+std::string_view translate(TextId text, bool english) {
+    // The file always gets English, whatever the UI shows
+    if (english) return TRANSLATION_TABLE[text.id].text[static_cast<size_t>(Language::ENGLISH)];
+    return Translations::instance().get(text.id);
+}
+
+void append_value(std::string& out, const LogField::Value& value, bool json, bool english) {
+    if (auto v = std::get_if<int64_t>(&value)) out += std::to_string(*v);
+    else if (auto v = std::get_if<uint64_t>(&value)) out += std::to_string(*v);
+    else if (auto v = std::get_if<bool>(&value)) out += *v ? "true" : "false";
+    else if (auto v = std::get_if<double>(&value)) {
+        if (json && !std::isfinite(*v)) {
+            out += "null";
+        } else {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.15g", *v);
+            out += buf;
+        }
+    } else if (auto v = std::get_if<std::string>(&value)) {
+        if (json) append_json_string(out, *v);
+        else out += *v;
+    } else if (auto v = std::get_if<TextId>(&value)) {
+        if (json) append_json_string(out, translate(*v, english));
+        else out += translate(*v, english);
+    }
+}
+
+// The file again, as a raw descriptor the crash path can write to without locks
+int open_crash_fd() {
+#if defined(_WIN32)
+    return _open(LOG_PATH, _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(LOG_PATH, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+#endif
+}
+
+void close_crash_fd(int fd) {
+    if (fd < 0) return;
+#if defined(_WIN32)
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+// One JSON line built in a fixed buffer, for use from a signal handler: no
+// allocation, no locks, no locale or time zone lookups. Too long a line is cut.
+class CrashLine {
+public:
+    void raw(std::string_view text) {
+        for (char c : text) put(c);
+    }
+
+    // The inside of a JSON string, escaped
+    void escaped(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        for (char c : text) {
+            switch (c) {
+            case '"': raw("\\\""); break;
+            case '\\': raw("\\\\"); break;
+            case '\n': raw("\\n"); break;
+            case '\r': raw("\\r"); break;
+            case '\t': raw("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    raw("\\u00");
+                    put(hex[(c >> 4) & 0xF]);
+                    put(hex[c & 0xF]);
+                } else {
+                    put(c);
+                }
+            }
+        }
+    }
+
+    void number(uint64_t value, int min_digits = 1) {
+        char digits[20];
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0 || count < min_digits);
+        while (count > 0) put(digits[--count]);
+    }
+
+    void number(int64_t value) {
+        if (value < 0) put('-');
+        number(value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value));
+    }
+
+    // Three decimals are plenty for the durations and ratios we log
+    void number(double value) {
+        if (!std::isfinite(value) || std::fabs(value) >= 1e15) {
+            raw("null");
+            return;
+        }
+        if (value < 0) put('-');
+        uint64_t thousandths = static_cast<uint64_t>(std::fabs(value) * 1000.0 + 0.5);
+        number(thousandths / 1000);
+        put('.');
+        number(thousandths % 1000, 3);
+    }
+
+    void value(const LogField::Value& field, bool quoted) {
+        if (auto v = std::get_if<int64_t>(&field)) number(*v);
+        else if (auto v = std::get_if<uint64_t>(&field)) number(*v);
+        else if (auto v = std::get_if<bool>(&field)) raw(*v ? "true" : "false");
+        else if (auto v = std::get_if<double>(&field)) number(*v);
+        else {
+            auto s = std::get_if<std::string>(&field);
+            auto t = std::get_if<TextId>(&field);
+            std::string_view text = s ? std::string_view(*s) : t ? translate(*t, true) : std::string_view();
+            if (quoted) put('"');
+            escaped(text);
+            if (quoted) put('"');
+        }
+    }
+
+    // "YYYY-MM-DDTHH:MM:SS.mmmZ" from the epoch by hand; gmtime takes a lock in glibc
+    void timestamp(std::chrono::system_clock::time_point when) {
+        using namespace std::chrono;
+        int64_t ms = duration_cast<milliseconds>(when.time_since_epoch()).count();
+        int64_t days = ms / 86400000;
+        int64_t in_day = ms % 86400000;
+        if (in_day < 0) {
+            in_day += 86400000;
+            days -= 1;
+        }
+        // Howard Hinnant's civil_from_days
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        int64_t doe = days - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        int64_t day = doy - (153 * mp + 2) / 5 + 1;
+        int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+        number(static_cast<uint64_t>(year), 4);
+        put('-');
+        number(static_cast<uint64_t>(month), 2);
+        put('-');
+        number(static_cast<uint64_t>(day), 2);
+        put('T');
+        number(static_cast<uint64_t>(in_day / 3600000), 2);
+        put(':');
+        number(static_cast<uint64_t>(in_day / 60000 % 60), 2);
+        put(':');
+        number(static_cast<uint64_t>(in_day / 1000 % 60), 2);
+        put('.');
+        number(static_cast<uint64_t>(in_day % 1000), 3);
+        put('Z');
+    }
+
+    // The same object the file sink writes, "{}" filled in
+    void entry(const LogEntry& entry) {
+        raw("{\"ts\":\"");
+        timestamp(entry.when);
+        raw("\",\"level\":\"");
+        raw(level_name(entry.level));
+        raw("\",\"component\":\"");
+        escaped(entry.component);
+        put('"');
+        if (entry.message_id != LogEntry::NO_MESSAGE_ID) {
+            raw(",\"msg_id\":\"");
+            escaped(TRANSLATION_TABLE[entry.message_id].key);
+            put('"');
+        }
+
+        std::string_view pattern = entry.message_id == LogEntry::NO_MESSAGE_ID
+                                       ? std::string_view(entry.text)
+                                       : translate(TextId{ entry.message_id }, true);
+        raw(",\"msg\":\"");
+        size_t pos = 0;
+        for (const auto& field : entry.fields) {
+            size_t hole = pattern.find("{}", pos);
+            if (hole == std::string_view::npos) break;
+            escaped(pattern.substr(pos, hole - pos));
+            value(field.value, false);
+            pos = hole + 2;
+        }
+        escaped(pattern.substr(pos));
+        put('"');
+
+        for (const auto& field : entry.fields) {
+            put(',');
+            put('"');
+            escaped(field.key);
+            raw("\":");
+            value(field.value, true);
+        }
+    }
+
+    // Closes the object; there is always room kept for it
+    std::string_view finish() {
+        std::memcpy(buf_ + len_, "}\n", 2);
+        return { buf_, len_ + 2 };
+    }
+
+private:
+    char buf_[4096];
+    size_t len_ = 0;
+
+    void put(char c) {
+        if (len_ < sizeof(buf_) - 2) buf_[len_++] = c;
+    }
+};
+
+void write_fd(int fd, std::string_view text) {
+    while (!text.empty()) {
+#if defined(_WIN32)
+        int n = _write(fd, text.data(), static_cast<unsigned>(text.size()));
+        if (n <= 0) return;
+#else
+        ssize_t n = ::write(fd, text.data(), text.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+#endif
+        text.remove_prefix(static_cast<size_t>(n));
+    }
+}
+
+#if defined(AUTOCONNECT_HAVE_ZLIB)
+bool gzip_file(const std::string& from, const std::string& to) {
+    FILE* in = std::fopen(from.c_str(), "rb");
+    if (!in) return false;
+    gzFile out = gzopen(to.c_str(), "wb9");
+    if (!out) {
+        std::fclose(in);
+        return false;
+    }
+
+    char buf[64 * 1024];
+    bool ok = true;
+    size_t n;
+    while (ok && (n = std::fread(buf, 1, sizeof(buf), in)) > 0) {
+        ok = gzwrite(out, buf, static_cast<unsigned>(n)) == static_cast<int>(n);
+    }
+    std::fclose(in);
+    return gzclose(out) == Z_OK && ok;
+}
+#endif
+}
 
 Logger& Logger::instance() {
     static Logger instance;
@@ -12,39 +315,332 @@ Logger& Logger::instance() {
 
 Logger::Logger() {
     if (!std::filesystem::exists("logs")) std::filesystem::create_directory("logs");
-    log_file.open("logs/autoconnect.log", std::ios::app);
+    log_file.open(LOG_PATH, std::ios::app);
+    crash_fd_ = open_crash_fd();
+    std::error_code ec;
+    file_bytes_ = std::filesystem::file_size(LOG_PATH, ec);
+    if (ec) file_bytes_ = 0;
+
+    if (const char* level = std::getenv("AUTOCONNECT_LOG_LEVEL")) {
+        std::string_view name(level);
+        if (name == "debug") set_level(LogLevel::Debug);
+        else if (name == "warn") set_level(LogLevel::Warn);
+        else if (name == "error") set_level(LogLevel::Error);
+    }
+
+    Record* stub = new Record;
+    head_.store(stub);
+    tail_ = stub;
 }
 
 Logger::~Logger() {
+    set_async(false);
+    delete tail_;
     if (log_file.is_open()) log_file.close();
+    close_crash_fd(crash_fd_.exchange(-1));
+}
+
+void Logger::set_level(LogLevel level) {
+    min_level_.store(level, std::memory_order_relaxed);
+}
+
+void Logger::update_prefixes(std::time_t second) {
+    if (second == prefix_second_) return;
+
+    // localtime/gmtime aren't thread-safe, but only one thread formats at a time
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "[%H:%M:%S] ", std::localtime(&second));
+    prefix_ = buf;
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", std::gmtime(&second));
+    iso_second_ = buf;
+    prefix_second_ = second;
 }
 
 void Logger::log(std::string_view message) {
+    log(LogLevel::Info, "app", message);
+}
+
+void Logger::log(LogLevel level, const char* component, std::string_view message,
+                 std::initializer_list<LogField> fields) {
+    if (!enabled(level)) return;
+    submit({ std::chrono::system_clock::now(), level, component, LogEntry::NO_MESSAGE_ID, std::string(message),
+             std::vector<LogField>(fields) });
+}
+
+void Logger::log(LogLevel level, const char* component, TextId message, std::initializer_list<LogField> fields) {
+    if (!enabled(level)) return;
+    submit({ std::chrono::system_clock::now(), level, component, message.id, {}, std::vector<LogField>(fields) });
+}
+
+void Logger::submit(LogEntry entry) {
+    if (async_.load(std::memory_order_acquire)) {
+        Record* record = new Record;
+        record->entry = std::move(entry);
+        push(record);
+        return;
+    }
+
+    std::string file_batch, console_batch;
     std::lock_guard<std::mutex> lock(log_mutex);
-    
-    auto now = std::chrono::system_clock::now();
-    auto time_val = std::chrono::system_clock::to_time_t(now);
-    
-    std::stringstream ss;
-    ss << "[" << std::put_time(std::localtime(&time_val), "%H:%M:%S") << "] " << message;
-    
-    std::string formatted = ss.str();
-    
-    if (log_file.is_open()) log_file << formatted << std::endl;
-    std::cout << formatted << std::endl;
-    memory_log.push_back(formatted);
-    
-    if (ui_callback) ui_callback(formatted);
+    emit(entry, file_batch, console_batch);
+    write_batches(file_batch, console_batch);
+}
+
+void Logger::push(Record* record) {
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    Record* prev = head_.exchange(record, std::memory_order_acq_rel);
+    prev->next.store(record, std::memory_order_release);
+}
+
+std::string Logger::render_message(const LogEntry& entry, bool english) {
+    std::string_view pattern = entry.message_id == LogEntry::NO_MESSAGE_ID
+                                   ? std::string_view(entry.text)
+                                   : translate(TextId{ entry.message_id }, english);
+
+    std::string out;
+    size_t next_field = 0;
+    size_t pos = 0;
+    while (next_field < entry.fields.size()) {
+        size_t hole = pattern.find("{}", pos);
+        if (hole == std::string_view::npos) break;
+        out.append(pattern.substr(pos, hole - pos));
+        append_value(out, entry.fields[next_field++].value, false, english);
+        pos = hole + 2;
+    }
+    out.append(pattern.substr(pos));
+
+    // The file has every field as its own key already
+    if (english) return out;
+    for (; next_field < entry.fields.size(); ++next_field) {
+        out += ' ';
+        out += entry.fields[next_field].key;
+        out += '=';
+        append_value(out, entry.fields[next_field].value, false, false);
+    }
+    return out;
+}
+
+std::string Logger::render(const LogEntry& entry) {
+    std::time_t second = std::chrono::system_clock::to_time_t(entry.when);
+    std::tm local{};
+#if defined(_WIN32)
+    localtime_s(&local, &second);
+#else
+    localtime_r(&second, &local);
+#endif
+    char prefix[16];
+    std::strftime(prefix, sizeof(prefix), "[%H:%M:%S] ", &local);
+    return prefix + render_message(entry, false);
+}
+
+void Logger::emit(const LogEntry& entry, std::string& file_batch, std::string& console_batch) {
+    using namespace std::chrono;
+    update_prefixes(system_clock::to_time_t(entry.when));
+
+    // Console and memory log get it in today's language; the UI renders its own copy
+    std::string line = prefix_ + render_message(entry, false);
+    console_batch += line;
+    console_batch += '\n';
+    memory_log.append(line);
+    if (ui_callback) ui_callback(entry);
+
+    // The file gets one JSON object per line
+    auto ms = duration_cast<milliseconds>(entry.when.time_since_epoch()).count() % 1000;
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03dZ", static_cast<int>(ms < 0 ? ms + 1000 : ms));
+    file_batch += "{\"ts\":\"" + iso_second_ + millis + "\",\"level\":\"" + level_name(entry.level) +
+                  "\",\"component\":";
+    append_json_string(file_batch, entry.component);
+    if (entry.message_id != LogEntry::NO_MESSAGE_ID) {
+        file_batch += ",\"msg_id\":";
+        append_json_string(file_batch, TRANSLATION_TABLE[entry.message_id].key);
+    }
+    file_batch += ",\"msg\":";
+    append_json_string(file_batch, render_message(entry, true));
+    for (const auto& field : entry.fields) {
+        file_batch += ',';
+        append_json_string(file_batch, field.key);
+        file_batch += ':';
+        append_value(file_batch, field.value, true, true);
+    }
+    file_batch += "}\n";
+}
+
+void Logger::write_batches(const std::string& file_batch, const std::string& console_batch) {
+    std::cout.write(console_batch.data(), console_batch.size()).flush();
+    if (!log_file.is_open()) return;
+
+    log_file.write(file_batch.data(), file_batch.size()).flush();
+    file_bytes_ += file_batch.size();
+    if (file_bytes_ >= MAX_FILE_BYTES) rotate();
+}
+
+void Logger::rotate() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    log_file.close();
+
+    // Every name a slot can have moves together, so uncompressed leftovers are
+    // pruned like the rest instead of piling up
+    auto rotated = [](int n, const char* suffix) { return std::string(LOG_PATH) + "." + std::to_string(n) + suffix; };
+    for (const char* suffix : ROTATED_SUFFIXES) {
+        fs::remove(rotated(KEEP_ROTATED, suffix), ec);
+        for (int n = KEEP_ROTATED - 1; n >= 1; --n) fs::rename(rotated(n, suffix), rotated(n + 1, suffix), ec);
+    }
+
+#if defined(AUTOCONNECT_HAVE_ZLIB)
+    if (gzip_file(LOG_PATH, rotated(1, ".gz"))) {
+        fs::remove(LOG_PATH, ec);
+    } else {
+        fs::remove(rotated(1, ".gz"), ec);
+        fs::rename(LOG_PATH, rotated(1, ""), ec);
+    }
+#else
+    fs::rename(LOG_PATH, rotated(1, ""), ec);
+#endif
+
+    log_file.open(LOG_PATH, std::ios::app);
+    close_crash_fd(crash_fd_.exchange(open_crash_fd()));
+    file_bytes_ = fs::file_size(LOG_PATH, ec);
+    if (ec) file_bytes_ = 0;
+}
+
+size_t Logger::drain() {
+    std::vector<Record*> records;
+    Record* tail = tail_;
+    while (Record* next = tail->next.load(std::memory_order_acquire)) {
+        records.push_back(next);
+        tail = next;
+    }
+    if (records.empty()) return 0;
+
+    // One write and one flush per batch instead of one per line
+    std::string file_batch, console_batch;
+    {
+        std::lock_guard<std::mutex> lock(log_mutex);
+        for (Record* record : records) {
+            emit(record->entry, file_batch, console_batch);
+            // A big backlog still rotates at the right size
+            if (file_bytes_ + file_batch.size() >= MAX_FILE_BYTES) {
+                write_batches(file_batch, console_batch);
+                file_batch.clear();
+                console_batch.clear();
+            }
+        }
+        write_batches(file_batch, console_batch);
+    }
+
+    // The last record stays behind as the new stub; a producer may still be linking onto it
+    delete tail_;
+    for (size_t i = 0; i + 1 < records.size(); ++i) delete records[i];
+    tail_ = records.back();
+    return records.size();
+}
+
+void Logger::writer_loop() {
+    while (true) {
+        bool stop = stopping_.load();
+        size_t written = 0;
+        if (!draining_.test_and_set(std::memory_order_acquire)) {
+            written = drain();
+            draining_.clear(std::memory_order_release);
+        }
+
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        written_ += written;
+        flushed_.notify_all();
+        if (stop) return;
+        writer_wake_.wait_for(lock, FLUSH_INTERVAL);
+    }
+}
+
+void Logger::set_async(bool enable) {
+    static std::mutex mode_mutex;
+    std::lock_guard<std::mutex> mode_lock(mode_mutex);
+    if (enable == async_.load()) return;
+
+    if (enable) {
+        stopping_ = false;
+        async_.store(true, std::memory_order_release);
+        writer_ = std::thread([this] { writer_loop(); });
+
+        static bool handlers_installed = false;
+        if (!handlers_installed) {
+            for (int sig : { SIGSEGV, SIGABRT, SIGFPE, SIGILL }) std::signal(sig, on_fatal_signal);
+            g_previous_terminate = std::set_terminate(on_terminate);
+            handlers_installed = true;
+        }
+        return;
+    }
+
+    // New messages go the synchronous way from here; the writer empties the queue and stops
+    async_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        stopping_ = true;
+    }
+    writer_wake_.notify_all();
+    writer_.join();
+
+    // Anything a producer pushed after the writer's last pass
+    while (draining_.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    drain();
+    draining_.clear(std::memory_order_release);
+}
+
+void Logger::flush() {
+    if (!async_.load()) return;
+
+    uint64_t target = queued_.load();
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    writer_wake_.notify_all();
+    flushed_.wait(lock, [&] { return written_ >= target || stopping_; });
+}
+
+void Logger::drain_for_crash() {
+    // Runs in a signal handler, maybe on a thread that crashed inside malloc or
+    // holding one of our locks. So: no allocation and no locks. Queued records
+    // are formatted on the stack and written to the file descriptor as they are;
+    // console, memory log and UI callback are skipped. If the writer is mid-batch
+    // (it may be what crashed) its records can't be walked safely, so give up.
+    Logger& logger = instance();
+    int fd = logger.crash_fd_.load();
+    if (fd < 0 || !logger.async_.load() || logger.draining_.test_and_set()) return;
+
+    for (Record* record = logger.tail_->next.load(std::memory_order_acquire); record;
+         record = record->next.load(std::memory_order_acquire)) {
+        CrashLine line;
+        line.entry(record->entry);
+        write_fd(fd, line.finish());
+    }
+}
+
+void Logger::on_fatal_signal(int sig) {
+    drain_for_crash();
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+void Logger::on_terminate() {
+    drain_for_crash();
+    if (g_previous_terminate) g_previous_terminate();
+    std::abort();
 }
 
 std::string Logger::get_logs() const {
     std::string result;
-    for (const auto& line : memory_log) result += line + "\n";
+    read_logs_since(0, [&](uint64_t, std::string_view line) {
+        result += line;
+        result += '\n';
+    });
     return result;
 }
 
+uint64_t Logger::read_logs_since(uint64_t seq, const LogRing::Visitor& visit) const {
+    return memory_log.for_each_since(seq, visit);
+}
+
 void Logger::clear() {
-    std::lock_guard<std::mutex> lock(log_mutex);
     memory_log.clear();
 }
 
@@ -7,26 +7,180 @@
 #include <vector>
 #include <functional>
 #include <string_view>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <ctime>
+#include <cstdint>
+#include <chrono>
+#include <initializer_list>
+#include <type_traits>
+#include <variant>
+#include "log_ring.h"
+#include "translations.h"
+
+enum class LogLevel { Debug, Info, Warn, Error };
+
+// A translation table entry, looked up only when the record is rendered; see TR_ID.
+struct TextId {
+    size_t id;
+};
+
+// A typed key/value attached to a log record. Values are kept as they are and
+// only turned into text when a sink writes the record.
+struct LogField {
+    using Value = std::variant<int64_t, uint64_t, double, bool, std::string, TextId>;
+
+    const char* key;
+    Value value;
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+    LogField(const char* k, T v) : key(k), value(static_cast<int64_t>(v)) {}
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    LogField(const char* k, T v) : key(k), value(static_cast<uint64_t>(v)) {}
+    LogField(const char* k, bool v) : key(k), value(v) {}
+    LogField(const char* k, double v) : key(k), value(v) {}
+    LogField(const char* k, std::string_view v) : key(k), value(std::string(v)) {}
+    LogField(const char* k, const char* v) : key(k), value(std::string(v)) {}
+    LogField(const char* k, const std::string& v) : key(k), value(v) {}
+    LogField(const char* k, TextId v) : key(k), value(v) {}
+};
+
+// What a sink gets. The message is a template: each "{}" in it takes the next
+// field's value, and fields left over are shown as key=value after it. With a
+// message_id the template is that translation, picked in the language the
+// line is rendered in.
+struct LogEntry {
+    static constexpr size_t NO_MESSAGE_ID = static_cast<size_t>(-1);
+
+    std::chrono::system_clock::time_point when;
+    LogLevel level = LogLevel::Info;
+    const char* component = "app";
+    size_t message_id = NO_MESSAGE_ID;
+    std::string text;
+    std::vector<LogField> fields;
+};
 
 class Logger {
 public:
     static Logger& instance();
 
+    // Free text; recorded as an info message from the "app" component.
     void log(std::string_view message);
+
+    // component should be a string literal; it is kept by pointer. Prefer the
+    // LOG_INFO/LOG_WARN/... macros, which skip building the arguments when the
+    // level is filtered out.
+    void log(LogLevel level, const char* component, std::string_view message,
+             std::initializer_list<LogField> fields = {});
+    // Same, with a translated template (LOG_TR); nothing is translated until a sink renders it.
+    void log(LogLevel level, const char* component, TextId message, std::initializer_list<LogField> fields = {});
+
+    // "[HH:MM:SS] " plus the rendered message, in the current language.
+    static std::string render(const LogEntry& entry);
+
+    bool enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+    // Defaults to Info, or AUTOCONNECT_LOG_LEVEL (debug, info, warn, error) if set.
+    void set_level(LogLevel level);
+
     std::string get_logs() const;
     void clear();
 
-    using LogCallback = std::function<void(std::string_view)>;
+    // Zero-copy read of the in-memory log; see LogRing::for_each_since. Pass
+    // the returned value next time to get only the lines added since.
+    uint64_t read_logs_since(uint64_t seq, const LogRing::Visitor& visit) const;
+
+    // The in-memory log keeps the newest lines within these limits
+    static constexpr size_t MEMORY_LOG_BYTES = 1024 * 1024;
+    static constexpr size_t MEMORY_LOG_LINES = 10000;
+
+    // Gets every entry unrendered, so a view can render (and re-render) it itself.
+    using LogCallback = std::function<void(const LogEntry&)>;
     void set_callback(LogCallback callback);
 
+    // Async mode: log() only stamps the message and pushes it onto a lock-free
+    // queue; a background thread does the file, console, memory and callback
+    // work in batches. Whatever is queued is written when async mode is turned
+    // off, at exit and (best effort, to the file only) on a crash.
+    void set_async(bool enable);
+
+    // Blocks until everything logged so far has been written.
+    void flush();
+
+    // How long the writer sleeps between batches
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 20 };
+
+    // The log file holds one JSON object per line. Past MAX_FILE_BYTES it is
+    // moved to autoconnect.log.1.gz (plain autoconnect.log.1 without zlib or
+    // if gzip fails), the older ones shift up and only KEEP_ROTATED are kept.
+    static constexpr uintmax_t MAX_FILE_BYTES = 5 * 1024 * 1024;
+    static constexpr int KEEP_ROTATED = 5;
+
 private:
     Logger();
     ~Logger();
 
+    // Intrusive MPSC queue (Vyukov): producers swap themselves in at head_,
+    // the writer walks from tail_, which always points at a consumed node.
+    struct Record {
+        std::atomic<Record*> next{ nullptr };
+        LogEntry entry;
+    };
+
     std::ofstream log_file;
+    // Same file, opened O_APPEND for the crash path's raw writes
+    std::atomic<int> crash_fd_{ -1 };
+    uintmax_t file_bytes_ = 0;
     std::mutex log_mutex;
-    std::vector<std::string> memory_log;
+    std::atomic<LogLevel> min_level_{ LogLevel::Info };
+    LogRing memory_log{ MEMORY_LOG_BYTES, MEMORY_LOG_LINES };
     LogCallback ui_callback = nullptr;
+
+    std::atomic<Record*> head_;
+    Record* tail_;
+    std::atomic<bool> async_{ false };
+    std::atomic<bool> stopping_{ false };
+    std::atomic_flag draining_ = ATOMIC_FLAG_INIT;
+    std::atomic<uint64_t> queued_{ 0 };
+    uint64_t written_ = 0;
+    std::mutex writer_mutex_;
+    std::condition_variable writer_wake_, flushed_;
+    std::thread writer_;
+
+    // Timestamps for the last second seen, local "[HH:MM:SS] " for people and
+    // UTC "YYYY-MM-DDTHH:MM:SS" for the file; only used under log_mutex
+    std::time_t prefix_second_ = -1;
+    std::string prefix_, iso_second_;
+
+    void update_prefixes(std::time_t second);
+    void push(Record* record);
+    void submit(LogEntry entry);
+    // The message with its "{}" filled in; english renders the way the log file
+    // wants it, otherwise the current language is used and leftover fields are added.
+    static std::string render_message(const LogEntry& entry, bool english);
+    // Formats one record into the batches and hands it to the memory log and UI callback
+    void emit(const LogEntry& entry, std::string& file_batch, std::string& console_batch);
+    // Writes both batches with one flush each; rotates the file when it gets too big
+    void write_batches(const std::string& file_batch, const std::string& console_batch);
+    void rotate();
+    size_t drain();
+    void writer_loop();
+    static void drain_for_crash();
+    static void on_fatal_signal(int sig);
+    static void on_terminate();
 };
 
 void LOG(std::string_view msg);
+
+#define LOG_AT(level, component, message, ...) \
+    do { \
+        if (Logger::instance().enabled(level)) Logger::instance().log(level, component, message, { __VA_ARGS__ }); \
+    } while (0)
+#define LOG_DEBUG(component, message, ...) LOG_AT(LogLevel::Debug, component, message, __VA_ARGS__)
+#define LOG_INFO(component, message, ...) LOG_AT(LogLevel::Info, component, message, __VA_ARGS__)
+#define LOG_WARN(component, message, ...) LOG_AT(LogLevel::Warn, component, message, __VA_ARGS__)
+#define LOG_ERROR(component, message, ...) LOG_AT(LogLevel::Error, component, message, __VA_ARGS__)
+
+// TR_ID("key") is a TextId checked against the translation table at compile time.
+#define TR_ID(key) TextId{ std::integral_constant<size_t, Translations::id(key)>::value }
+#define LOG_TR(level, component, key, ...) LOG_AT(level, component, TR_ID(key), __VA_ARGS__)
@@ -0,0 +1,157 @@
+#include "metrics.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+static const std::string SUMMARY_FILE = "logs/latency_summary.json";
+
+static std::string json_escape(std::string_view text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+static std::string format_ms(double ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ms);
+    return buf;
+}
+
+Metrics& Metrics::instance() {
+    static Metrics instance;
+    return instance;
+}
+
+void Metrics::record(std::string_view name, double milliseconds) {
+    LOG_DEBUG("metrics", "Span", {"name", name}, {"ms", milliseconds});
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& h = histograms_[std::string(name)];
+
+    if (h.count == 0 || milliseconds < h.min_ms) h.min_ms = milliseconds;
+    if (h.count == 0 || milliseconds > h.max_ms) h.max_ms = milliseconds;
+    h.count++;
+    h.total_ms += milliseconds;
+
+    auto bound = std::lower_bound(BUCKET_BOUNDS.begin(), BUCKET_BOUNDS.end(), milliseconds);
+    h.buckets[static_cast<size_t>(bound - BUCKET_BOUNDS.begin())]++;
+}
+
+// Estimated from the buckets: linear within the bucket holding the rank,
+// clamped to the observed min/max so small samples don't report nonsense.
+double Metrics::Histogram::percentile(double p) const {
+    if (count == 0) return 0;
+    double rank = p * static_cast<double>(count);
+    unsigned long seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] == 0) continue;
+        if (static_cast<double>(seen + buckets[i]) >= rank) {
+            double lower = i == 0 ? 0 : BUCKET_BOUNDS[i - 1];
+            double upper = i < BUCKET_BOUNDS.size() ? BUCKET_BOUNDS[i] : max_ms;
+            double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(buckets[i]);
+            double value = lower + (upper - lower) * fraction;
+            return std::clamp(value, min_ms, max_ms);
+        }
+        seen += buckets[i];
+    }
+    return max_ms;
+}
+
+std::string Metrics::summary_json() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::time_t now = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::ostringstream out;
+    out << "{\n  \"generated\": \"" << stamp << "\",\n  \"spans\": {";
+    bool first = true;
+    for (const auto& [name, h] : histograms_) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    \"" << json_escape(name) << "\": {"
+            << "\"count\": " << h.count
+            << ", \"total_ms\": " << format_ms(h.total_ms)
+            << ", \"min_ms\": " << format_ms(h.min_ms)
+            << ", \"max_ms\": " << format_ms(h.max_ms)
+            << ", \"mean_ms\": " << format_ms(h.total_ms / static_cast<double>(h.count))
+            << ", \"p50_ms\": " << format_ms(h.percentile(0.50))
+            << ", \"p90_ms\": " << format_ms(h.percentile(0.90))
+            << ", \"p99_ms\": " << format_ms(h.percentile(0.99))
+            << ", \"buckets\": [";
+        // Only non-empty buckets; "le" is the upper bound, null for the overflow bucket
+        bool first_bucket = true;
+        for (size_t i = 0; i < h.buckets.size(); ++i) {
+            if (h.buckets[i] == 0) continue;
+            if (!first_bucket) out << ", ";
+            first_bucket = false;
+            out << "{\"le\": ";
+            if (i < BUCKET_BOUNDS.size()) out << BUCKET_BOUNDS[i];
+            else out << "null";
+            out << ", \"count\": " << h.buckets[i] << "}";
+        }
+        out << "]}";
+    }
+    out << (first ? "}\n}\n" : "\n  }\n}\n");
+    return out.str();
+}
+
+bool Metrics::write_summary() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (histograms_.empty()) return false;
+    }
+    std::string json = summary_json();
+
+    std::error_code ec;
+    if (!std::filesystem::exists("logs", ec)) std::filesystem::create_directory("logs", ec);
+
+    const std::string temp = SUMMARY_FILE + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << json;
+        if (!out) return false;
+    }
+    std::filesystem::rename(temp, SUMMARY_FILE, ec);
+    return !ec;
+}
+
+void Metrics::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    histograms_.clear();
+}
+
+ScopedSpan::ScopedSpan(std::string name) : name_(std::move(name)), start_(std::chrono::steady_clock::now()) {
+}
+
+ScopedSpan::~ScopedSpan() {
+    if (!finished_) finish();
+}
+
+double ScopedSpan::finish() {
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    if (!finished_) {
+        finished_ = true;
+        Metrics::instance().record(name_, ms);
+    }
+    return ms;
+}
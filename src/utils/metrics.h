@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <array>
+#include <chrono>
+#include <string_view>
+
+// In-process latency histograms, one per span name. Spans are recorded by
+// ScopedSpan and dumped as JSON next to the log at the end of a run, so we
+// can see where a setup's time actually goes.
+class Metrics {
+public:
+    static Metrics& instance();
+
+    void record(std::string_view name, double milliseconds);
+
+    // JSON object: { "spans": { name: { count, total_ms, min_ms, max_ms, mean_ms, p50_ms, p90_ms, p99_ms, buckets } } }
+    std::string summary_json();
+
+    // Writes summary_json() to logs/latency_summary.json (temp file + rename).
+    // Does nothing if no span was recorded.
+    bool write_summary();
+
+    void clear();
+
+private:
+    Metrics() = default;
+
+    // Upper bounds in ms; the last bucket catches everything above
+    static constexpr std::array<double, 16> BUCKET_BOUNDS = {
+        1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000, 120000
+    };
+
+    struct Histogram {
+        unsigned long count = 0;
+        double total_ms = 0;
+        double min_ms = 0;
+        double max_ms = 0;
+        std::array<unsigned long, BUCKET_BOUNDS.size() + 1> buckets{};
+
+        double percentile(double p) const;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Histogram> histograms_;
+};
+
+// Times its own lifetime and records it under name. finish() records early;
+// the destructor then does nothing.
+class ScopedSpan {
+public:
+    explicit ScopedSpan(std::string name);
+    ~ScopedSpan();
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    double finish();
+
+private:
+    std::string name_;
+    std::chrono::steady_clock::time_point start_;
+    bool finished_ = false;
+};
@@ -0,0 +1,119 @@
+#include "retry_scheduler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    class SystemClock : public Clock {
+    public:
+        time_point now() override { return std::chrono::steady_clock::now(); }
+        void sleep_for(std::chrono::milliseconds duration) override { CancellationToken::current().wait_for(duration); }
+    };
+
+    // initial, max, multiplier, jitter, deadline. WiFiConnect bounds a whole
+    // connect; with the 10 s portal timeout that keeps Complete Setup near 2.5 min worst case.
+    // The pause-only phases (ConnectAttempt, MethodSwitch) are bounded by that outer deadline.
+    const std::array<BackoffPolicy, static_cast<size_t>(RetryPhase::COUNT)> POLICIES = { {
+        { 0ms, 0ms, 1.0, 0.0, 120s },          // WiFiConnect
+        { 0ms, 0ms, 1.0, 0.0, 45s },           // Activation
+        { 50ms, 250ms, 2.0, 0.2, 2s },         // ProfilePropagation
+        { 250ms, 2s, 1.5, 0.2, 30s },          // Association
+        { 1s, 3s, 2.0, 0.2, 120s },            // ConnectAttempt
+        { 100ms, 1s, 2.0, 0.2, 10s },          // LinkSettle
+        { 250ms, 1s, 2.0, 0.2, 120s },         // MethodSwitch
+        { 5s, 300s, 2.0, 0.2, 0s },            // AgentReconnect; delays only, no deadline
+        { 0ms, 0ms, 1.0, 0.0, 4s },            // FreshScan
+    } };
+
+}
+
+Clock& Clock::system() {
+    static SystemClock clock;
+    return clock;
+}
+
+Deadline::Deadline(std::chrono::milliseconds budget, Clock& clock)
+    : clock_(clock), end_(clock.now() + budget), token_(CancellationToken::current()) {
+}
+
+std::chrono::milliseconds Deadline::remaining() const {
+    if (token_.cancelled()) return 0ms;
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(end_ - clock_.now());
+    return std::max(left, 0ms);
+}
+
+bool Deadline::expired() const {
+    return remaining() == 0ms;
+}
+
+int Deadline::remaining_seconds() const {
+    auto ms = remaining().count();
+    return std::max(1, static_cast<int>((ms + 999) / 1000));
+}
+
+std::chrono::milliseconds Deadline::capped(std::chrono::milliseconds cap) const {
+    return std::min(remaining(), cap);
+}
+
+RetryScheduler::RetryScheduler(RetryPhase phase, const Deadline* outer)
+    : RetryScheduler(policy(phase), Clock::system(), std::random_device{}(), outer) {
+}
+
+RetryScheduler::RetryScheduler(const BackoffPolicy& policy, Clock& clock, uint32_t seed, const Deadline* outer)
+    : policy_(policy), clock_(clock), deadline_(policy.deadline, clock), outer_(outer), random_(seed),
+      current_ms_(static_cast<double>(policy.initial.count())) {
+}
+
+std::chrono::milliseconds RetryScheduler::next_delay() {
+    double base = std::min(current_ms_, static_cast<double>(policy_.max.count()));
+    current_ms_ = std::min(current_ms_ * policy_.multiplier, static_cast<double>(policy_.max.count()));
+
+    double factor = 1.0;
+    if (policy_.jitter > 0) {
+        std::uniform_real_distribution<double> spread(-policy_.jitter, policy_.jitter);
+        factor += spread(random_);
+    }
+    return std::chrono::milliseconds(static_cast<long long>(std::llround(base * factor)));
+}
+
+std::chrono::milliseconds RetryScheduler::remaining() const {
+    auto left = deadline_.remaining();
+    if (outer_) left = std::min(left, outer_->remaining());
+    return left;
+}
+
+bool RetryScheduler::expired() const {
+    return remaining() == 0ms;
+}
+
+int RetryScheduler::attempts() const {
+    return attempts_;
+}
+
+bool RetryScheduler::run(const std::function<bool()>& attempt, const Wait& wait) {
+    while (true) {
+        attempts_++;
+        if (attempt()) return true;
+
+        auto left = remaining();
+        if (left == 0ms) return false;
+
+        auto delay = std::min(next_delay(), left);
+        if (wait) wait(delay);
+        else clock_.sleep_for(delay);
+    }
+}
+
+bool RetryScheduler::pause() {
+    auto left = remaining();
+    if (left == 0ms) return false;
+    clock_.sleep_for(std::min(next_delay(), left));
+    return true;
+}
+
+BackoffPolicy RetryScheduler::policy(RetryPhase phase) {
+    return POLICIES[static_cast<size_t>(phase)];
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <functional>
+#include "cancellation.h"
+
+// Time source for Deadline/RetryScheduler. The system clock is used unless a
+// different one is passed in, so the timing can be driven by a fake clock.
+// The system clock's sleep_for wakes up early when the thread's current
+// CancellationToken is cancelled.
+class Clock {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~Clock() = default;
+    virtual time_point now() = 0;
+    virtual void sleep_for(std::chrono::milliseconds duration) = 0;
+
+    static Clock& system();
+};
+
+// A fixed point in time an operation must finish by. Cancelling the token that
+// was current when it was created expires it at once, so every loop bounded by
+// the deadline unwinds.
+class Deadline {
+public:
+    explicit Deadline(std::chrono::milliseconds budget, Clock& clock = Clock::system());
+
+    std::chrono::milliseconds remaining() const;   // never negative
+    bool expired() const;
+
+    // remaining() rounded up to whole seconds, at least 1. For run_command timeouts.
+    int remaining_seconds() const;
+
+    // The smaller of remaining() and cap
+    std::chrono::milliseconds capped(std::chrono::milliseconds cap) const;
+
+private:
+    Clock& clock_;
+    Clock::time_point end_;
+    CancellationToken token_;
+};
+
+enum class RetryPhase {
+    WiFiConnect,         // whole WiFiManager::connect; only the deadline is used
+    Activation,          // one nmcli up / D-Bus activation; only the deadline is used
+    ProfilePropagation,  // waiting for a freshly added Windows profile to show up
+    Association,         // polling for "connected" after asking to connect
+    ConnectAttempt,      // pause between Windows connect attempts
+    LinkSettle,          // waiting for carrier + address after activation
+    MethodSwitch,        // pause between EAP methods
+    AgentReconnect,      // reconnect agent: delay before retrying a dropped link
+    FreshScan,           // waiting for a triggered scan when nothing is cached; only the deadline is used
+    COUNT
+};
+
+struct BackoffPolicy {
+    std::chrono::milliseconds initial;
+    std::chrono::milliseconds max;
+    double multiplier;
+    double jitter;                        // +/- fraction of each delay
+    std::chrono::milliseconds deadline;   // overall budget for the phase
+};
+
+// Exponential backoff with jitter under a deadline. run() keeps calling an
+// attempt until it succeeds or time runs out; between tries it either sleeps
+// or hands the delay to a wait function, which can return early when a
+// readiness event (netlink, D-Bus) arrives.
+class RetryScheduler {
+public:
+    using Wait = std::function<void(std::chrono::milliseconds)>;
+
+    // Phase defaults, optionally bounded by an outer deadline as well.
+    explicit RetryScheduler(RetryPhase phase, const Deadline* outer = nullptr);
+    // Explicit policy, clock and jitter seed; what tests/retry_scheduler_test.cpp drives.
+    RetryScheduler(const BackoffPolicy& policy, Clock& clock, uint32_t seed, const Deadline* outer = nullptr);
+
+    // True as soon as attempt() does; false once the deadline has passed.
+    // attempt() always runs at least once, and once more at the deadline.
+    bool run(const std::function<bool()>& attempt, const Wait& wait = nullptr);
+
+    // Sleeps the next backoff delay, cut short by the deadline. False if the
+    // deadline had already passed.
+    bool pause();
+
+    std::chrono::milliseconds next_delay();
+    std::chrono::milliseconds remaining() const;
+    bool expired() const;
+    int attempts() const;
+
+    static BackoffPolicy policy(RetryPhase phase);
+
+private:
+    BackoffPolicy policy_;
+    Clock& clock_;
+    Deadline deadline_;
+    const Deadline* outer_;
+    std::mt19937 random_;
+    double current_ms_;
+    int attempts_ = 0;
+};
@@ -1,4 +1,7 @@
 #include "system_utils.h"
+#include "metrics.h"
+#include "cancellation.h"
+#include <algorithm>
 #include <array>
 #include <memory>
 #include <iostream>
@@ -12,14 +15,517 @@
 #else
     #include <unistd.h>
     #include <sys/types.h>
+    #include <sys/wait.h>
     #include <pwd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <spawn.h>
+    #include <signal.h>
+    #include <cerrno>
+    #include <cstring>
+    #include <chrono>
+    #include <atomic>
+    #include <mutex>
+    #include <random>
+    #include <cstdlib>
     #define POPEN popen
     #define PCLOSE pclose
+
+extern char** environ;
 #endif
 
 namespace SystemUtils {
 
+    // "run_command:<program>" so every nmcli/netsh/gsettings call lands in its own histogram
+    static std::string command_span_name(std::string_view program) {
+        size_t end = program.find_first_of(" \t");
+        if (end != std::string_view::npos) program = program.substr(0, end);
+        while (!program.empty() && program.front() == '"') program.remove_prefix(1);
+        while (!program.empty() && program.back() == '"') program.remove_suffix(1);
+        size_t slash = program.find_last_of("/\\");
+        if (slash != std::string_view::npos) program = program.substr(slash + 1);
+        return "run_command:" + std::string(program);
+    }
+
+    const std::string& CommandResult::error_text() const {
+        return stderr_output.empty() ? stdout_output : stderr_output;
+    }
+
+#if !defined(_WIN32)
+    namespace {
+
+        std::atomic<bool> g_persistent_shell{false};
+        std::atomic<unsigned long> g_commands_run{0};
+        std::atomic<unsigned long> g_direct_spawns{0};
+        std::atomic<unsigned long> g_shell_restarts{0};
+        std::atomic<unsigned long> g_shell_commands{0};
+
+        void set_nonblocking(int fd) {
+            int flags = fcntl(fd, F_GETFL);
+            if (flags != -1) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+
+        // Drains whatever is readable right now. Returns false once the write end is closed.
+        bool drain_fd(int fd, std::string& into) {
+            std::array<char, 4096> buffer;
+            while (true) {
+                ssize_t n = read(fd, buffer.data(), buffer.size());
+                if (n > 0) {
+                    into.append(buffer.data(), static_cast<size_t>(n));
+                    continue;
+                }
+                if (n == 0) return false;
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+        }
+
+        int decode_wait_status(int status) {
+            if (WIFEXITED(status)) return WEXITSTATUS(status);
+            if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+            return -1;
+        }
+
+        // Writes all of data without letting a reader that went away kill us with
+        // SIGPIPE. Returns false if the write failed (EPIPE: nobody is reading).
+        bool write_no_sigpipe(int fd, std::string_view data) {
+            sigset_t pipe_set;
+            sigset_t old_set;
+            sigemptyset(&pipe_set);
+            sigaddset(&pipe_set, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+            bool ok = true;
+            bool broken_pipe = false;
+            size_t written = 0;
+            while (written < data.size()) {
+                ssize_t n = write(fd, data.data() + written, data.size() - written);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    broken_pipe = (errno == EPIPE);
+                    ok = false;
+                    break;
+                }
+                written += static_cast<size_t>(n);
+            }
+
+            // Consume the pending SIGPIPE so unblocking doesn't deliver it
+            if (broken_pipe) {
+                timespec no_wait = { 0, 0 };
+                sigtimedwait(&pipe_set, nullptr, &no_wait);
+            }
+            pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+            return ok;
+        }
+
+        // Writes a small stdin payload to a child that may exit early. Closes the fd either way.
+        void write_input(int fd, std::string_view input) {
+            write_no_sigpipe(fd, input);
+            close(fd);
+        }
+
+        CommandResult spawn_and_collect(const std::vector<std::string>& argv, int timeout_seconds, std::string_view input = {}) {
+            // Cancelled work shouldn't start anything new
+            if (CancellationToken::current().cancelled()) {
+                return { -1, "", (argv.empty() ? std::string("command") : argv[0]) + " cancelled", false };
+            }
+            CommandResult result;
+            result.exit_code = -1;
+            result.success = false;
+
+            if (argv.empty()) {
+                result.stderr_output = "empty command";
+                return result;
+            }
+
+            int out_pipe[2];
+            int err_pipe[2];
+            if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+                result.stderr_output = std::string("pipe2() failed: ") + std::strerror(errno);
+                return result;
+            }
+            if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+                result.stderr_output = std::string("pipe2() failed: ") + std::strerror(errno);
+                close(out_pipe[0]);
+                close(out_pipe[1]);
+                return result;
+            }
+
+            // Only commands that take input get a stdin pipe; the rest read /dev/null
+            int in_pipe[2] = { -1, -1 };
+            if (!input.empty() && pipe2(in_pipe, O_CLOEXEC) != 0) {
+                result.stderr_output = std::string("pipe2() failed: ") + std::strerror(errno);
+                close(out_pipe[0]);
+                close(out_pipe[1]);
+                close(err_pipe[0]);
+                close(err_pipe[1]);
+                return result;
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            if (in_pipe[0] >= 0) posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+            else posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+            // Own process group so a timeout can take down grandchildren too.
+            // Signals are reset because the UI installs its own SIGINT/SIGTERM handlers.
+            posix_spawnattr_t attr;
+            posix_spawnattr_init(&attr);
+            sigset_t no_signals;
+            sigemptyset(&no_signals);
+            sigset_t default_signals;
+            sigemptyset(&default_signals);
+            sigaddset(&default_signals, SIGINT);
+            sigaddset(&default_signals, SIGTERM);
+            sigaddset(&default_signals, SIGPIPE);
+            posix_spawnattr_setsigmask(&attr, &no_signals);
+            posix_spawnattr_setsigdefault(&attr, &default_signals);
+            posix_spawnattr_setpgroup(&attr, 0);
+            posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+            std::vector<char*> c_argv;
+            c_argv.reserve(argv.size() + 1);
+            for (const auto& arg : argv) c_argv.push_back(const_cast<char*>(arg.c_str()));
+            c_argv.push_back(nullptr);
+
+            pid_t pid = -1;
+            int spawn_err = posix_spawnp(&pid, c_argv[0], &actions, &attr, c_argv.data(), environ);
+
+            posix_spawn_file_actions_destroy(&actions);
+            posix_spawnattr_destroy(&attr);
+            close(out_pipe[1]);
+            close(err_pipe[1]);
+            if (in_pipe[0] >= 0) close(in_pipe[0]);
+
+            if (spawn_err != 0) {
+                if (in_pipe[1] >= 0) close(in_pipe[1]);
+                close(out_pipe[0]);
+                close(err_pipe[0]);
+                result.exit_code = 127;
+                result.stderr_output = argv[0] + ": " + std::strerror(spawn_err);
+                return result;
+            }
+
+            g_direct_spawns++;
+            // Payloads here are small config fragments that fit in the pipe buffer
+            if (in_pipe[1] >= 0) write_input(in_pipe[1], input);
+            set_nonblocking(out_pipe[0]);
+            set_nonblocking(err_pipe[0]);
+
+            using Clock = std::chrono::steady_clock;
+            const bool has_deadline = timeout_seconds > 0;
+            const auto deadline = Clock::now() + std::chrono::seconds(timeout_seconds);
+            const auto token = CancellationToken::current();
+            const int check_ms = static_cast<int>(CancellationToken::CHECK_INTERVAL.count());
+            bool cancelled = false;
+
+            pollfd fds[2] = {
+                { out_pipe[0], POLLIN, 0 },
+                { err_pipe[0], POLLIN, 0 },
+            };
+            bool out_open = true;
+            bool err_open = true;
+
+            while (out_open || err_open) {
+                if (token.cancelled()) {
+                    cancelled = true;
+                    break;
+                }
+                int wait_ms = check_ms;
+                if (has_deadline) {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                    if (left <= 0) {
+                        result.timed_out = true;
+                        break;
+                    }
+                    wait_ms = static_cast<int>(std::min<long long>(left, check_ms));
+                }
+
+                fds[0].fd = out_open ? out_pipe[0] : -1;
+                fds[1].fd = err_open ? err_pipe[0] : -1;
+                int ready = poll(fds, 2, wait_ms);
+                if (ready < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                if (ready == 0) continue;
+
+                if (out_open && fds[0].revents) out_open = drain_fd(out_pipe[0], result.stdout_output);
+                if (err_open && fds[1].revents) err_open = drain_fd(err_pipe[0], result.stderr_output);
+            }
+
+            close(out_pipe[0]);
+            close(err_pipe[0]);
+
+            int status = 0;
+            if (!result.timed_out && !cancelled) {
+                // Output is closed, but the child may still be running (e.g. it
+                // daemonised a helper holding the pipe). Keep honouring the deadline.
+                while (true) {
+                    pid_t done = waitpid(pid, &status, has_deadline ? WNOHANG : 0);
+                    if (done == pid) break;
+                    if (done < 0 && errno != EINTR) break;
+                    if (done == 0) {
+                        if (token.cancelled()) {
+                            cancelled = true;
+                            break;
+                        }
+                        if (Clock::now() >= deadline) {
+                            result.timed_out = true;
+                            break;
+                        }
+                        usleep(1000);
+                    }
+                }
+            }
+
+            if (result.timed_out || cancelled) {
+                kill(-pid, SIGKILL);
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+                result.exit_code = -1;
+                result.success = false;
+                if (!result.stderr_output.empty() && result.stderr_output.back() != '\n') result.stderr_output += "\n";
+                if (cancelled) result.stderr_output += argv[0] + " cancelled";
+                else result.stderr_output += argv[0] + " timed out after " + std::to_string(timeout_seconds) + "s";
+                return result;
+            }
+
+            result.exit_code = decode_wait_status(status);
+            result.success = (result.exit_code == 0);
+            return result;
+        }
+
+        // One /bin/sh kept alive for the life of the process. Each command is
+        // written to its stdin followed by printf markers on stdout and stderr,
+        // so we know where the output ends and what the exit status was.
+        class WorkerShell {
+        public:
+            ~WorkerShell() { stop(); }
+
+            std::mutex mutex;
+
+            // False only if the command was never handed to the shell (caller may spawn it instead).
+            bool run(const std::string& cmd, int timeout_seconds, CommandResult& result) {
+                if (pid_ <= 0 && !start()) return false;
+
+                const std::string marker = "__AUTOCONNECT_DONE_" + std::to_string(++sequence_) + "_" + nonce_ + "__";
+                std::string script = "{\n" + cmd + "\n} </dev/null\n"
+                                     "__ac_rc=$?\n"
+                                     "printf '\\n%s %d\\n' '" + marker + "' \"$__ac_rc\"\n"
+                                     "printf '\\n%s\\n' '" + marker + "' >&2\n";
+                if (!write_all(script)) {
+                    stop();
+                    return false;
+                }
+
+                using Clock = std::chrono::steady_clock;
+                const bool has_deadline = timeout_seconds > 0;
+                const auto deadline = Clock::now() + std::chrono::seconds(timeout_seconds);
+                const std::string needle = "\n" + marker;
+
+                const auto token = CancellationToken::current();
+                const int check_ms = static_cast<int>(CancellationToken::CHECK_INTERVAL.count());
+                bool cancelled = false;
+
+                std::string out;
+                std::string err;
+                size_t out_end = std::string::npos;
+                size_t err_end = std::string::npos;
+                bool shell_alive = true;
+
+                while (shell_alive && (out_end == std::string::npos || err_end == std::string::npos)) {
+                    if (token.cancelled()) {
+                        cancelled = true;
+                        break;
+                    }
+                    int wait_ms = check_ms;
+                    if (has_deadline) {
+                        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                        if (left <= 0) {
+                            result.timed_out = true;
+                            break;
+                        }
+                        wait_ms = static_cast<int>(std::min<long long>(left, check_ms));
+                    }
+
+                    pollfd fds[2] = {
+                        { out_end == std::string::npos ? out_fd_ : -1, POLLIN, 0 },
+                        { err_end == std::string::npos ? err_fd_ : -1, POLLIN, 0 },
+                    };
+                    int ready = poll(fds, 2, wait_ms);
+                    if (ready < 0) {
+                        if (errno == EINTR) continue;
+                        shell_alive = false;
+                        break;
+                    }
+                    if (ready == 0) continue;
+
+                    if (fds[0].revents) {
+                        shell_alive = drain_fd(out_fd_, out) && shell_alive;
+                        out_end = out.find(needle);
+                    }
+                    if (fds[1].revents) {
+                        shell_alive = drain_fd(err_fd_, err) && shell_alive;
+                        err_end = err.find(needle);
+                    }
+                }
+
+                if (result.timed_out || cancelled || out_end == std::string::npos || err_end == std::string::npos) {
+                    // The command hung, was cancelled or the shell died under it.
+                    // Kill it and start a fresh one next time. The command may already
+                    // have run, so this is a failure, never a reason to run it again.
+                    stop();
+                    result.exit_code = -1;
+                    result.success = false;
+                    result.stdout_output = out;
+                    if (!err.empty() && err.back() != '\n') err += '\n';
+                    if (cancelled) result.stderr_output = err + "command cancelled";
+                    else if (result.timed_out) result.stderr_output = err + "command timed out after " + std::to_string(timeout_seconds) + "s";
+                    else result.stderr_output = err + "shell exited before the command finished";
+                    return true;
+                }
+
+                int exit_code = std::atoi(out.c_str() + out_end + needle.size());
+                out.resize(out_end);
+                err.resize(err_end);
+
+                result.exit_code = exit_code;
+                result.stdout_output = std::move(out);
+                result.stderr_output = std::move(err);
+                result.success = (exit_code == 0);
+                return true;
+            }
+
+            void stop() {
+                if (in_fd_ >= 0) close(in_fd_);
+                if (out_fd_ >= 0) close(out_fd_);
+                if (err_fd_ >= 0) close(err_fd_);
+                in_fd_ = out_fd_ = err_fd_ = -1;
+                if (pid_ > 0) {
+                    kill(-pid_, SIGKILL);
+                    int status = 0;
+                    while (waitpid(pid_, &status, 0) < 0 && errno == EINTR) {}
+                }
+                pid_ = -1;
+            }
+
+        private:
+            pid_t pid_ = -1;
+            int in_fd_ = -1;
+            int out_fd_ = -1;
+            int err_fd_ = -1;
+            unsigned long sequence_ = 0;
+            std::string nonce_;
+
+            bool start();
+
+            // False with EPIPE when the shell has died (killed, OOM, a command ran exit)
+            bool write_all(const std::string& data) {
+                return write_no_sigpipe(in_fd_, data);
+            }
+        };
+
+        WorkerShell& worker_shell() {
+            static WorkerShell shell;
+            return shell;
+        }
+
+        bool WorkerShell::start() {
+            int in_pipe[2];
+            int out_pipe[2];
+            int err_pipe[2];
+            if (pipe2(in_pipe, O_CLOEXEC) != 0) return false;
+            if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+                close(in_pipe[0]);
+                close(in_pipe[1]);
+                return false;
+            }
+            if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+                close(in_pipe[0]);
+                close(in_pipe[1]);
+                close(out_pipe[0]);
+                close(out_pipe[1]);
+                return false;
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+            posix_spawnattr_t attr;
+            posix_spawnattr_init(&attr);
+            sigset_t no_signals;
+            sigemptyset(&no_signals);
+            sigset_t default_signals;
+            sigemptyset(&default_signals);
+            sigaddset(&default_signals, SIGINT);
+            sigaddset(&default_signals, SIGTERM);
+            sigaddset(&default_signals, SIGPIPE);
+            posix_spawnattr_setsigmask(&attr, &no_signals);
+            posix_spawnattr_setsigdefault(&attr, &default_signals);
+            posix_spawnattr_setpgroup(&attr, 0);
+            posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+            char sh[] = "/bin/sh";
+            char* argv[] = { sh, nullptr };
+            pid_t pid = -1;
+            int spawn_err = posix_spawn(&pid, sh, &actions, &attr, argv, environ);
+
+            posix_spawn_file_actions_destroy(&actions);
+            posix_spawnattr_destroy(&attr);
+            close(in_pipe[0]);
+            close(out_pipe[1]);
+            close(err_pipe[1]);
+
+            if (spawn_err != 0) {
+                close(in_pipe[1]);
+                close(out_pipe[0]);
+                close(err_pipe[0]);
+                return false;
+            }
+
+            g_direct_spawns++;
+            if (sequence_ > 0) g_shell_restarts++;
+
+            pid_ = pid;
+            in_fd_ = in_pipe[1];
+            out_fd_ = out_pipe[0];
+            err_fd_ = err_pipe[0];
+            set_nonblocking(out_fd_);
+            set_nonblocking(err_fd_);
+
+            std::random_device rd;
+            nonce_ = std::to_string(rd()) + std::to_string(pid);
+            return true;
+        }
+
+        // Returns true if the persistent shell took the command, whatever its outcome.
+        bool run_in_worker_shell(const std::string& cmd, int timeout_seconds, CommandResult& result) {
+            // Cancelled work falls through to spawn_and_collect, which refuses it
+            if (!g_persistent_shell || CancellationToken::current().cancelled()) return false;
+            auto& shell = worker_shell();
+            std::unique_lock<std::mutex> lock(shell.mutex, std::try_to_lock);
+            if (!lock.owns_lock()) return false;
+            if (!shell.run(cmd, timeout_seconds, result)) return false;
+            g_shell_commands++;
+            return true;
+        }
+
+    }
+#endif
+
     CommandResult run_command(std::string_view cmd, int timeout_seconds) {
+        ScopedSpan span(command_span_name(cmd));
+#if !defined(_WIN32)
+        g_commands_run++;
+        CommandResult shell_result{ -1, "", "", false };
+        if (run_in_worker_shell(std::string(cmd), timeout_seconds, shell_result)) return shell_result;
+        return spawn_and_collect({ "/bin/sh", "-c", std::string(cmd) }, timeout_seconds);
+#else
         CommandResult result;
         result.exit_code = -1;
         result.success = false;
@@ -50,6 +556,81 @@ namespace SystemUtils {
         result.success = (return_code == 0);
         
         return result;
+#endif
+    }
+
+    CommandResult run_command(const std::vector<std::string>& argv, int timeout_seconds) {
+#if !defined(_WIN32)
+        ScopedSpan span(command_span_name(argv.empty() ? "" : argv.front()));
+        g_commands_run++;
+        // Never through the worker shell: it would fork/exec argv[0] all the same,
+        // and credentials in argv would end up in a shell script again
+        return spawn_and_collect(argv, timeout_seconds);
+#else
+        // No posix_spawn here; quote the arguments and go through the shell path.
+        std::string cmd;
+        for (const auto& arg : argv) {
+            if (!cmd.empty()) cmd += ' ';
+            cmd += '"' + arg + '"';
+        }
+        return run_command(std::string_view(cmd), timeout_seconds);
+#endif
+    }
+
+    CommandResult run_command_with_input(const std::vector<std::string>& argv, std::string_view input, int timeout_seconds) {
+#if !defined(_WIN32)
+        ScopedSpan span(command_span_name(argv.empty() ? "" : argv.front()));
+        g_commands_run++;
+        return spawn_and_collect(argv, timeout_seconds, input);
+#else
+        // popen can't do both directions; commands taking input are POSIX-only for now
+        (void)input;
+        return run_command(argv, timeout_seconds);
+#endif
+    }
+
+    void set_persistent_shell(bool enabled) {
+#if !defined(_WIN32)
+        g_persistent_shell = enabled;
+        if (!enabled) {
+            auto& shell = worker_shell();
+            std::lock_guard<std::mutex> lock(shell.mutex);
+            shell.stop();
+        }
+#else
+        (void)enabled;
+#endif
+    }
+
+    bool persistent_shell_enabled() {
+#if !defined(_WIN32)
+        return g_persistent_shell;
+#else
+        return false;
+#endif
+    }
+
+    CommandStats get_command_stats() {
+#if !defined(_WIN32)
+        return { g_commands_run.load(), g_direct_spawns.load(), g_shell_restarts.load(), g_shell_commands.load() };
+#else
+        return { 0, 0, 0, 0 };
+#endif
+    }
+
+    std::string fingerprint(std::string_view data) {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+        for (int i = 15; i >= 0; --i) {
+            hex[static_cast<size_t>(i)] = digits[hash & 0xF];
+            hash >>= 4;
+        }
+        return hex;
     }
 
     bool is_admin() {
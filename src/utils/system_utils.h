@@ -11,10 +11,50 @@ namespace SystemUtils {
         std::string stdout_output;
         std::string stderr_output;
         bool success;
+        bool timed_out = false;
+
+        // stderr when the command wrote any, stdout otherwise. Handy for error messages.
+        const std::string& error_text() const;
     };
 
+    // Runs a shell command line. Kept for the Windows netsh calls and anything
+    // that really needs shell syntax; prefer the argv overload below.
     CommandResult run_command(std::string_view cmd, int timeout_seconds = 30);
 
+    // Runs argv[0] directly (PATH lookup, no shell). stdout and stderr are
+    // collected separately and the child is killed once timeout_seconds pass.
+    // A timeout of 0 or less waits forever.
+    CommandResult run_command(const std::vector<std::string>& argv, int timeout_seconds = 30);
+
+    // Same as the argv overload, but input is written to the child's stdin.
+    // Always spawns directly, even in persistent shell mode.
+    CommandResult run_command_with_input(const std::vector<std::string>& argv, std::string_view input, int timeout_seconds = 30);
+
+    // Persistent shell mode: command lines given to the string overload are fed
+    // to one long-lived /bin/sh over a pipe instead of a fresh /bin/sh -c each,
+    // saving that shell's fork/exec; the shell still forks for every external
+    // program it runs. argv commands always spawn directly. If the shell is busy
+    // with another thread's command, the call falls back to a direct spawn.
+    // Off by default; POSIX only, ignored on Windows. The shell keeps the
+    // environment it was started with.
+    void set_persistent_shell(bool enabled);
+    bool persistent_shell_enabled();
+
+    struct CommandStats {
+        unsigned long commands_run;
+        // Processes started by us (direct spawns and worker shells). Whatever
+        // those run in turn, e.g. the worker shell's commands, isn't counted.
+        unsigned long direct_spawns;
+        unsigned long shell_restarts;
+        // Command lines the worker shell ran; each one is a /bin/sh spawn saved
+        unsigned long shell_commands;
+    };
+
+    CommandStats get_command_stats();
+
+    // 64-bit FNV-1a of data as 16 hex digits. For change detection, not security.
+    std::string fingerprint(std::string_view data);
+
     bool is_admin();
     std::string get_os_type();
     std::string get_system_summary();
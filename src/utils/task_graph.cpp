@@ -0,0 +1,67 @@
+#include "task_graph.h"
+#include "metrics.h"
+#include "cancellation.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+size_t TaskGraph::add(std::string name, Task task, std::vector<size_t> after) {
+    size_t id = nodes_.size();
+    // Anything that isn't an earlier task can never finish first; drop it
+    after.erase(std::remove_if(after.begin(), after.end(), [id](size_t dep) { return dep >= id; }), after.end());
+    nodes_.push_back({ std::move(name), std::move(task), std::move(after) });
+    return id;
+}
+
+std::vector<TaskOutcome> TaskGraph::run(const Report& report) {
+    const size_t count = nodes_.size();
+    std::vector<TaskOutcome> outcomes(count);
+    std::vector<bool> started(count, false), done(count, false);
+    size_t finished = 0;
+
+    std::mutex mutex;
+    std::condition_variable all_done;
+    std::vector<std::thread> threads;
+    const auto token = CancellationToken::current();
+
+    // Called with the lock held; starts every task whose dependencies are done
+    std::function<void()> start_ready;
+    start_ready = [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            if (started[i]) continue;
+            const auto& after = nodes_[i].after;
+            if (!std::all_of(after.begin(), after.end(), [&](size_t dep) { return done[dep]; })) continue;
+
+            started[i] = true;
+            threads.emplace_back([&, i]() {
+                CancellationScope scope(token);
+                ScopedSpan span("task:" + nodes_[i].name);
+                TaskResult result{ false, "Cancelled" };
+                try {
+                    if (!token.cancelled()) result = nodes_[i].task();
+                } catch (...) {
+                    result = { false, "Unexpected error" };
+                }
+                TaskOutcome outcome{ nodes_[i].name, std::move(result), span.finish() };
+                if (report) report(outcome);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                outcomes[i] = std::move(outcome);
+                done[i] = true;
+                finished++;
+                start_ready();
+                if (finished == count) all_done.notify_all();
+            });
+        }
+    };
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        start_ready();
+        all_done.wait(lock, [&] { return finished == count; });
+    }
+    // Nothing starts new threads once everything has finished
+    for (auto& thread : threads) thread.join();
+    return outcomes;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+struct TaskResult {
+    bool success;
+    std::string message;
+};
+
+struct TaskOutcome {
+    std::string name;
+    TaskResult result;
+    double elapsed_ms;
+};
+
+// Runs a handful of blocking tasks as a dependency graph: every task starts on
+// its own thread as soon as the tasks it comes after have finished (whatever
+// their result), so independent work overlaps. Tasks can only name tasks added
+// before them, which keeps the graph free of cycles. They run under the
+// caller's CancellationToken.
+class TaskGraph {
+public:
+    using Task = std::function<TaskResult()>;
+    using Report = std::function<void(const TaskOutcome&)>;
+
+    // Returns the task's id for use in later tasks' `after`.
+    size_t add(std::string name, Task task, std::vector<size_t> after = {});
+
+    // Blocks until every task has finished. report is called from the task's
+    // thread as each one finishes; outcomes come back in the order added.
+    std::vector<TaskOutcome> run(const Report& report = nullptr);
+
+private:
+    struct Node {
+        std::string name;
+        Task task;
+        std::vector<size_t> after;
+    };
+    std::vector<Node> nodes_;
+};
@@ -0,0 +1,135 @@
+#include "translation_catalogue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char MAGIC[4] = { 'A', 'C', 'T', 'C' };
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 16;
+
+uint32_t read_u32(const unsigned char* p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+void append_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+}
+
+TranslationCatalogue::~TranslationCatalogue() {
+#if defined(_WIN32)
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+#else
+    if (data_) munmap(const_cast<unsigned char*>(data_), length_);
+#endif
+}
+
+std::unique_ptr<TranslationCatalogue> TranslationCatalogue::open(const std::string& path) {
+    std::unique_ptr<TranslationCatalogue> catalogue(new TranslationCatalogue);
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    catalogue->file_ = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(HEADER_SIZE)) return nullptr;
+    catalogue->length_ = static_cast<size_t>(size.QuadPart);
+
+    catalogue->mapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!catalogue->mapping_) return nullptr;
+    catalogue->data_ = static_cast<const unsigned char*>(MapViewOfFile(catalogue->mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!catalogue->data_) return nullptr;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_SIZE)) {
+        close(fd);
+        return nullptr;
+    }
+    catalogue->length_ = static_cast<size_t>(st.st_size);
+
+    // The mapping outlives the descriptor
+    void* data = mmap(nullptr, catalogue->length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    catalogue->data_ = static_cast<const unsigned char*>(data);
+#endif
+
+    const unsigned char* data_start = catalogue->data_;
+    if (std::memcmp(data_start, MAGIC, sizeof(MAGIC)) != 0 || read_u32(data_start + 4) != VERSION) return nullptr;
+
+    const uint64_t count = read_u32(data_start + 8);
+    const uint64_t pool_size = read_u32(data_start + 12);
+    const uint64_t index_bytes = count * sizeof(IndexEntry);
+    if (HEADER_SIZE + index_bytes + pool_size > catalogue->length_) return nullptr;
+
+    catalogue->count_ = static_cast<size_t>(count);
+    catalogue->index_ = reinterpret_cast<const IndexEntry*>(data_start + HEADER_SIZE);
+    catalogue->pool_ = reinterpret_cast<const char*>(data_start + HEADER_SIZE + index_bytes);
+
+    // Bounds only; reading the index doesn't pull in the pool
+    for (size_t i = 0; i < catalogue->count_; ++i) {
+        const IndexEntry& entry = catalogue->index_[i];
+        if (uint64_t(entry.key_offset) + entry.key_length > pool_size ||
+            uint64_t(entry.text_offset) + entry.text_length > pool_size) return nullptr;
+    }
+    return catalogue;
+}
+
+std::string_view TranslationCatalogue::key_at(size_t i) const {
+    return { pool_ + index_[i].key_offset, index_[i].key_length };
+}
+
+std::optional<std::string_view> TranslationCatalogue::find(std::string_view key) const {
+    size_t low = 0, high = count_;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int order = key_at(mid).compare(key);
+        if (order == 0) return std::string_view(pool_ + index_[mid].text_offset, index_[mid].text_length);
+        if (order < 0) low = mid + 1;
+        else high = mid;
+    }
+    return std::nullopt;
+}
+
+bool TranslationCatalogue::write(const std::string& path, std::vector<std::pair<std::string, std::string>> entries) {
+    // std::map orders keys bytewise, the same order find() searches in
+    std::map<std::string, std::string> sorted;
+    for (auto& [key, text] : entries) sorted[std::move(key)] = std::move(text);
+
+    std::string index, pool;
+    for (const auto& [key, text] : sorted) {
+        append_u32(index, static_cast<uint32_t>(pool.size()));
+        append_u32(index, static_cast<uint32_t>(key.size()));
+        pool += key;
+        append_u32(index, static_cast<uint32_t>(pool.size()));
+        append_u32(index, static_cast<uint32_t>(text.size()));
+        pool += text;
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    append_u32(header, VERSION);
+    append_u32(header, static_cast<uint32_t>(sorted.size()));
+    append_u32(header, static_cast<uint32_t>(pool.size()));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out << header << index << pool;
+    return static_cast<bool>(out.flush());
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A translation catalogue file, memory-mapped read-only. Layout, all integers
+// little-endian uint32:
+//
+//   "ACTC" | version (1) | count | pool_size
+//   count x { key_offset, key_length, text_offset, text_length }, sorted by key bytes
+//   pool_size bytes of key and text strings (offsets are from the pool start)
+//
+// Opening only checks the header and index bounds; the pool is paged in as
+// lookups touch it. The index is read in place, so the host must be
+// little-endian too (x86 and ARM are).
+class TranslationCatalogue {
+public:
+    ~TranslationCatalogue();
+
+    TranslationCatalogue(const TranslationCatalogue&) = delete;
+    TranslationCatalogue& operator=(const TranslationCatalogue&) = delete;
+
+    // nullptr if the file is missing or malformed.
+    static std::unique_ptr<TranslationCatalogue> open(const std::string& path);
+
+    // Writes entries (any order, later duplicates win) as a catalogue file.
+    static bool write(const std::string& path, std::vector<std::pair<std::string, std::string>> entries);
+
+    // Binary search; the view points into the mapping and lives as long as the catalogue.
+    std::optional<std::string_view> find(std::string_view key) const;
+
+    size_t size() const { return count_; }
+
+private:
+    TranslationCatalogue() = default;
+
+    struct IndexEntry {
+        uint32_t key_offset;
+        uint32_t key_length;
+        uint32_t text_offset;
+        uint32_t text_length;
+    };
+
+    const unsigned char* data_ = nullptr;
+    size_t length_ = 0;
+    const IndexEntry* index_ = nullptr;
+    const char* pool_ = nullptr;
+    size_t count_ = 0;
+#if defined(_WIN32)
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+
+    std::string_view key_at(size_t i) const;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+enum class Language {
+    ENGLISH,
+    SISWATI
+};
+
+struct TranslationEntry {
+    std::string_view key;
+    std::array<std::string_view, 2> text; // Indexed by Language
+};
+
+// Leave ss out and the siSwati column gets the English text, so a lookup
+// never has to fall back at run time.
+constexpr TranslationEntry tr(std::string_view key, std::string_view en, std::string_view ss = {}) {
+    return { key, { en, ss.empty() ? en : ss } };
+}
+
+// The whole catalogue. T("key") is resolved against it at compile time. A "{}"
+// marks where a log line's argument goes (see LogEntry).
+inline constexpr TranslationEntry TRANSLATION_TABLE[] = {
+    tr("app_title", "UNESWA WiFi AutoConnect", "UNESWA WiFi Kuxhumanisa"),
+    tr("app_subtitle", "ICT Society - University of Eswatini", "ICT Society - Nyuvesi yase-Eswatini"),
+    tr("app_version", "UNESWA WiFi AutoConnect v1.3.7 starting..."),
+    tr("status_fully_connected", "Status: Fully Connected", "Simo: Kuxhumene"),
+    tr("status_partially_connected", "Status: Partially Connected"),
+    tr("status_not_connected", "Status: Not Connected", "Simo: Akukaxhumani"),
+    tr("wifi_connected", "WiFi: Connected"),
+    tr("wifi_disconnected", "WiFi: Disconnected"),
+    tr("proxy_configured", "Proxy: Configured"),
+    tr("proxy_not_configured", "Proxy: Not Configured"),
+    tr("student_credentials", "Student Credentials", "Tintfo Temfundzi"),
+    tr("student_id", "Student ID:", "Inombolo Yemfundzi:"),
+    tr("student_id_placeholder", "e.g., 20211234"),
+    tr("password_mode", "Password Mode:"),
+    tr("birthday_mode", "Birthday (Default)"),
+    tr("custom_password_mode", "Custom Password"),
+    tr("birthday", "Birthday:"),
+    tr("password", "Password:"),
+    tr("birthday_placeholder", "ddmmyyyy (e.g., 12052001)"),
+    tr("password_placeholder", "Your custom password"),
+    tr("birthday_format", "Format: ddmmyyyy (e.g., 12052001 for 12 May 2001)"),
+    tr("password_format", "Use this if you changed your default password"),
+    tr("complete_setup", "Complete Setup (Ctrl+Enter)", "Lungisa Konke"),
+    tr("complete_setup_working", "Working..."),
+    tr("individual_actions", "Individual Actions", "Tintfo Letehlukahlukene"),
+    tr("wifi_only", "WiFi Only", "WiFi Kuphela"),
+    tr("proxy_only", "Config Network", "Lungisa I-Network"),
+    tr("register_device", "Register Device", "Bhalisa Lidivayisi"),
+    tr("test_connection", "Test Connection"),
+    tr("reset_uneswa", "Reset UNESWA", "Buyisela UNESWA"),
+    tr("activity_log", "Activity Log"),
+    tr("system_info", "System: {}"),
+    tr("admin_warning", "Warning: Not running with administrator privileges"),
+    tr("admin_warning_detail", "Some features may not work correctly"),
+    tr("operation_in_progress", "Operation already in progress"),
+    tr("credentials_required", "Student ID and birthday are required"),
+    tr("starting_setup", "Starting setup..."),
+    tr("setup_time_warning", "This may take 30-60 seconds..."),
+    tr("setup_completed_success", "Setup completed successfully!"),
+    tr("setup_completed_issues", "Setup finished with issues. Check logs."),
+    tr("testing_connection", "Testing connection..."),
+    tr("connection_all_operational", "Test: All operational"),
+    tr("connection_wifi_only", "Test: WiFi ok, proxy missing"),
+    tr("connection_not_connected", "Test: Not connected"),
+    tr("resetting_settings", "Resetting UNESWA settings..."),
+    tr("reset_complete", "Reset done"),
+    tr("wifi_success", "✓ WiFi: {}"),
+    tr("wifi_error", "✗ WiFi: {}"),
+    tr("registration_success", "✓ Registration: {}"),
+    tr("registration_error", "✗ Registration: {}"),
+    tr("proxy_success", "✓ Proxy: {}"),
+    tr("proxy_error", "✗ Proxy: {}"),
+    tr("language", "Language", "Lulwimi"),
+    tr("english", "English", "SiNgisi"),
+    tr("siswati", "siSwati", "siSwati"),
+    tr("info_title", "Password Information"),
+    tr("info_birthday_explanation", "Use if default password"),
+    tr("info_password_explanation", "Use if custom password"),
+    tr("info_tip", "Tip: Default is Birthday mode"),
+};
@@ -1,30 +1,71 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <string_view>
+#include "translation_table.h"
+#include "translation_catalogue.h"
 
-enum class Language {
-    ENGLISH,
-    SISWATI
-};
-
+// Built-in languages come from TRANSLATION_TABLE. Others, and newer texts for
+// the built-in ones, can ship as catalogue files (CATALOGUE_DIR/<code>.cat,
+// see TranslationCatalogue); a language's file is only opened the first time
+// set_language selects it, and stays mapped after that.
 class Translations {
 public:
     static Translations& instance();
+
+    static constexpr const char* CATALOGUE_DIR = "lang";
     
     void set_language(Language lang);
+    // "en" and "ss" are built in; anything else needs its catalogue file.
+    // False (and nothing changes) if there is none.
+    bool set_language(std::string_view code);
     Language get_language() const;
-    
-    std::string get(std::string_view key) const;
-    static std::string t(std::string_view key);
+
+    // Language part of the user's locale (LC_ALL, LC_MESSAGES or LANG; the user
+    // default locale on Windows), e.g. "zu" for zu_ZA.UTF-8. Empty if unset.
+    static std::string system_language_code();
+
+    // Position of key in TRANSLATION_TABLE. T() evaluates it at compile time,
+    // where running off the end (a key that isn't in the table) is an error.
+    static constexpr size_t id(std::string_view key) {
+        for (size_t i = 0; i < std::size(TRANSLATION_TABLE); ++i) {
+            if (TRANSLATION_TABLE[i].key == key) return i;
+        }
+        throw "unknown translation key";
+    }
+
+    // Text for id in the current language: the catalogue's if it has the key,
+    // the built-in table's otherwise. Never allocates.
+    std::string_view get(size_t id) const {
+        if (const auto* catalogue = current_catalogue.load(std::memory_order_acquire)) {
+            if (auto text = catalogue->find(TRANSLATION_TABLE[id].key)) return *text;
+        }
+        return TRANSLATION_TABLE[id].text[static_cast<size_t>(current_language.load(std::memory_order_relaxed))];
+    }
+
+    template <size_t Id>
+    static std::string_view t() {
+        static_assert(Id < std::size(TRANSLATION_TABLE));
+        return instance().get(Id);
+    }
 
 private:
-    Translations();
-    Language current_language = Language::ENGLISH;
-    
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> translations;
-    void load_translations();
+    Translations() = default;
+    std::atomic<Language> current_language{ Language::ENGLISH };
+    std::atomic<const TranslationCatalogue*> current_catalogue{ nullptr };
+
+    // Catalogues opened so far by code (nullptr: looked, none there); never
+    // closed, so a lookup racing a language switch still reads mapped memory
+    std::mutex catalogues_mutex;
+    std::map<std::string, std::unique_ptr<TranslationCatalogue>, std::less<>> catalogues;
+
+    const TranslationCatalogue* catalogue_for(std::string_view code);
 };
 
-#define T(key) Translations::t(key)
\ No newline at end of file
+#define T(key) Translations::t<Translations::id(key)>()
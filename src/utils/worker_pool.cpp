@@ -0,0 +1,68 @@
+#include "worker_pool.h"
+#include "logger.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threads) {
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) threads_.emplace_back([this] { work(); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cancel_all();
+    wake_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+CancellationToken WorkerPool::submit(std::function<void()> job) {
+    CancellationToken token;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) token.cancel();
+        queue_.push_back({ std::move(job), token });
+        pending_++;
+    }
+    wake_.notify_one();
+    return token;
+}
+
+void WorkerPool::cancel_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& job : queue_) job.token.cancel();
+    for (auto& token : running_) token.cancel();
+}
+
+bool WorkerPool::busy() const {
+    return pending_ > 0;
+}
+
+void WorkerPool::work() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            running_.push_back(job.token);
+        }
+
+        {
+            CancellationScope scope(job.token);
+            try {
+                job.run();
+            } catch (...) {
+                LOG_ERROR("worker", "Background task failed");
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(running_.begin(), running_.end(),
+                               [&](const CancellationToken& token) { return token.same_as(job.token); });
+        if (it != running_.end()) running_.erase(it);
+        pending_--;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cancellation.h"
+
+// A few long-lived threads working through a queue of jobs. Each job runs with
+// its own CancellationToken installed (see CancellationToken::current()), so
+// cancel_all() makes the connect and wait loops under it return early.
+// Cancelled jobs still get to run, with the token already set, so whatever
+// they do on the way out (resetting a busy flag) happens. Destroying the pool
+// cancels what's left, lets it drain and joins the threads.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threads = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queues job and returns the token it will run under.
+    CancellationToken submit(std::function<void()> job);
+
+    // Cancels running and queued jobs.
+    void cancel_all();
+
+    // True while any job is queued or running.
+    bool busy() const;
+
+private:
+    struct Job {
+        std::function<void()> run;
+        CancellationToken token;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> queue_;
+    std::vector<CancellationToken> running_;
+    std::atomic<size_t> pending_{ 0 };
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    void work();
+};
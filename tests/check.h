@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal assertions for the test executables: a failed CHECK is reported and
+// counted, and main() returns check_result() so ctest sees the failure.
+
+#include <iostream>
+
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            check_failures()++; \
+        } \
+    } while (0)
+
+inline int check_result(const char* suite) {
+    if (check_failures() > 0) {
+        std::cerr << check_failures() << " checks failed\n";
+        return 1;
+    }
+    std::cout << "All " << suite << " checks passed\n";
+    return 0;
+}
@@ -0,0 +1,96 @@
+/* ConnectionHistory: failed attempts count against a method only when they ran
+ * their course. A Cancel or an exhausted connect budget must not push a method
+ * that works to the back of order_methods. Runs in a scratch directory, since
+ * the history lives in data/ under the working directory. */
+
+#include "check.h"
+#include "network/connection_history.h"
+#include "utils/cancellation.h"
+#include "utils/retry_scheduler.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    const std::vector<std::string> METHODS = { "peap", "ttls", "peap-md5" };
+
+    std::string history_file() {
+        std::ifstream in("data/connection_history.tsv");
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    void failure_demotes_method() {
+        auto& history = ConnectionHistory::instance();
+        Deadline budget(120s);
+        CHECK(history.record_failure("ran", "wlan0", "peap", 900, budget));
+        CHECK((history.order_methods("ran", "wlan0", METHODS) == std::vector<std::string>{ "ttls", "peap-md5", "peap" }));
+        CHECK(history_file().find("ran\twlan0\tpeap\t0\t1\t") != std::string::npos);
+    }
+
+    void cancel_is_not_a_failure() {
+        // What pressing Cancel mid-connect looks like: the budget was taken
+        // under the connect's token, which is cancelled while the method runs
+        auto& history = ConnectionHistory::instance();
+        CancellationToken token;
+        CancellationScope scope(token);
+        Deadline budget(120s);
+        token.cancel();
+
+        CHECK(!history.record_failure("cancelled", "wlan0", "peap", 900, budget));
+        CHECK(!history.record_failure("cancelled", "wlan1", "peap", 900, budget));
+        CHECK(history.order_methods("cancelled", "wlan0", METHODS) == METHODS);
+        CHECK(history_file().find("cancelled\t") == std::string::npos);
+    }
+
+    void cancelled_thread_with_outer_budget() {
+        // A token cancelled after the budget was taken elsewhere still counts
+        auto& history = ConnectionHistory::instance();
+        Deadline budget(120s);
+        CancellationToken token;
+        CancellationScope scope(token);
+        token.cancel();
+
+        CHECK(!history.record_failure("worker", "wlan0", "ttls", 900, budget));
+        CHECK(history.order_methods("worker", "wlan0", METHODS) == METHODS);
+    }
+
+    void exhausted_budget_is_not_a_failure() {
+        auto& history = ConnectionHistory::instance();
+        Deadline budget(0ms);
+        CHECK(!history.record_failure("slow", "wlan0", "peap", 120000, budget));
+        CHECK(history.order_methods("slow", "wlan0", METHODS) == METHODS);
+    }
+
+    void success_still_wins() {
+        auto& history = ConnectionHistory::instance();
+        Deadline budget(120s);
+        history.record("mixed", "wlan0", "ttls", true, 1500);
+        CHECK(history.record_failure("mixed", "wlan0", "peap", 900, budget));
+        CHECK((history.order_methods("mixed", "wlan0", METHODS) == std::vector<std::string>{ "ttls", "peap-md5", "peap" }));
+    }
+
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "autoconnect_history_test";
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir);
+    fs::current_path(dir);
+
+    failure_demotes_method();
+    cancel_is_not_a_failure();
+    cancelled_thread_with_outer_budget();
+    exhausted_budget_is_not_a_failure();
+    success_still_wins();
+
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(dir, ec);
+    return check_result("connection history");
+}
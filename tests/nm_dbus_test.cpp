@@ -0,0 +1,466 @@
+/* NmDbus against a mock NetworkManager on a private bus. Run under
+ * dbus-run-session; the session bus stands in for the system bus through
+ * DBUS_SYSTEM_BUS_ADDRESS. The mock serves just what NmDbus calls (devices,
+ * settings, AddAndActivateConnection, Update, ActivateConnection, Delete,
+ * DeactivateConnection) and answers each activation the way the current
+ * scenario says: activated, deactivated with a reason, or no signal at all. */
+
+#include "check.h"
+#include "network/nm_dbus.h"
+#include "utils/cancellation.h"
+#include <dbus/dbus.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    const char* NM_SERVICE = "org.freedesktop.NetworkManager";
+    const char* NM_PATH = "/org/freedesktop/NetworkManager";
+    const char* DEVICE_PATH = "/org/freedesktop/NetworkManager/Devices/1";
+    const char* SETTINGS_PREFIX = "/org/freedesktop/NetworkManager/Settings/";
+    const char* ACTIVE_PREFIX = "/org/freedesktop/NetworkManager/ActiveConnection/";
+    const char* ACTIVE_IFACE = "org.freedesktop.NetworkManager.Connection.Active";
+
+    const uint32_t STATE_ACTIVATING = 1;
+    const uint32_t STATE_ACTIVATED = 2;
+    const uint32_t STATE_DEACTIVATED = 4;
+    const uint32_t REASON_NO_SECRETS = 9;
+
+    // Copies one value, containers included, from a message being read into one being built
+    void copy_value(DBusMessageIter* from, DBusMessageIter* to) {
+        int type = dbus_message_iter_get_arg_type(from);
+        if (dbus_type_is_basic(type)) {
+            DBusBasicValue value;
+            dbus_message_iter_get_basic(from, &value);
+            dbus_message_iter_append_basic(to, type, &value);
+            return;
+        }
+
+        DBusMessageIter sub_from, sub_to;
+        dbus_message_iter_recurse(from, &sub_from);
+        char* signature = nullptr;
+        const char* contained = nullptr;
+        if (type == DBUS_TYPE_ARRAY) {
+            signature = dbus_message_iter_get_signature(from);
+            contained = signature + 1;
+        } else if (type == DBUS_TYPE_VARIANT) {
+            signature = dbus_message_iter_get_signature(&sub_from);
+            contained = signature;
+        }
+        dbus_message_iter_open_container(to, type, contained, &sub_to);
+        if (type == DBUS_TYPE_ARRAY && dbus_type_is_fixed(dbus_message_iter_get_element_type(from))) {
+            const void* items = nullptr;
+            int count = 0;
+            dbus_message_iter_get_fixed_array(&sub_from, &items, &count);
+            dbus_message_iter_append_fixed_array(&sub_to, dbus_message_iter_get_element_type(from), &items, count);
+        } else {
+            while (dbus_message_iter_get_arg_type(&sub_from) != DBUS_TYPE_INVALID) {
+                copy_value(&sub_from, &sub_to);
+                dbus_message_iter_next(&sub_from);
+            }
+        }
+        dbus_message_iter_close_container(to, &sub_to);
+        dbus_free(signature);
+    }
+
+    void append_paths(DBusMessageIter* it, const std::vector<std::string>& paths) {
+        DBusMessageIter array;
+        dbus_message_iter_open_container(it, DBUS_TYPE_ARRAY, "o", &array);
+        for (const auto& path : paths) {
+            const char* value = path.c_str();
+            dbus_message_iter_append_basic(&array, DBUS_TYPE_OBJECT_PATH, &value);
+        }
+        dbus_message_iter_close_container(it, &array);
+    }
+
+    // "id" out of the a{sa{sv}} a message carries first
+    std::string settings_id(DBusMessage* settings) {
+        DBusMessageIter it, groups;
+        if (!dbus_message_iter_init(settings, &it) || dbus_message_iter_get_arg_type(&it) != DBUS_TYPE_ARRAY) return "";
+        dbus_message_iter_recurse(&it, &groups);
+        for (; dbus_message_iter_get_arg_type(&groups) == DBUS_TYPE_DICT_ENTRY; dbus_message_iter_next(&groups)) {
+            DBusMessageIter group, keys;
+            dbus_message_iter_recurse(&groups, &group);
+            const char* name = nullptr;
+            dbus_message_iter_get_basic(&group, &name);
+            if (std::string(name) != "connection") continue;
+            dbus_message_iter_next(&group);
+            dbus_message_iter_recurse(&group, &keys);
+            for (; dbus_message_iter_get_arg_type(&keys) == DBUS_TYPE_DICT_ENTRY; dbus_message_iter_next(&keys)) {
+                DBusMessageIter entry, variant;
+                dbus_message_iter_recurse(&keys, &entry);
+                const char* key = nullptr;
+                dbus_message_iter_get_basic(&entry, &key);
+                if (std::string(key) != "id") continue;
+                dbus_message_iter_next(&entry);
+                dbus_message_iter_recurse(&entry, &variant);
+                const char* id = nullptr;
+                dbus_message_iter_get_basic(&variant, &id);
+                return id ? id : "";
+            }
+        }
+        return "";
+    }
+
+    class MockNetworkManager {
+    public:
+        enum class Outcome { Activate, FailNoSecrets, Silent };
+
+        bool start() {
+            DBusError err;
+            dbus_error_init(&err);
+            conn_ = dbus_bus_get_private(DBUS_BUS_SYSTEM, &err);
+            if (!conn_) {
+                dbus_error_free(&err);
+                return false;
+            }
+            dbus_connection_set_exit_on_disconnect(conn_, FALSE);
+            int owned = dbus_bus_request_name(conn_, NM_SERVICE, DBUS_NAME_FLAG_DO_NOT_QUEUE, &err);
+            if (dbus_error_is_set(&err) || owned != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
+                dbus_error_free(&err);
+                return false;
+            }
+            thread_ = std::thread([this]() { serve(); });
+            return true;
+        }
+
+        ~MockNetworkManager() {
+            stopping_ = true;
+            if (thread_.joinable()) thread_.join();
+            if (conn_) {
+                dbus_connection_close(conn_);
+                dbus_connection_unref(conn_);
+            }
+            for (auto& [path, settings] : connections_) dbus_message_unref(settings);
+        }
+
+        void set_outcome(Outcome outcome) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            outcome_ = outcome;
+        }
+
+        // Method calls received, oldest first; cleared on read
+        std::vector<std::string> take_calls() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return std::exchange(calls_, {});
+        }
+
+    private:
+        struct Active {
+            std::string connection;
+            uint32_t state;
+            std::chrono::steady_clock::time_point signal_at;
+            bool signalled;
+            Outcome outcome;
+        };
+
+        DBusConnection* conn_ = nullptr;
+        std::thread thread_;
+        std::atomic<bool> stopping_{ false };
+        std::mutex mutex_;
+        Outcome outcome_ = Outcome::Activate;
+        std::vector<std::string> calls_;
+        // Settings path -> the message whose first argument is its a{sa{sv}}
+        std::map<std::string, DBusMessage*> connections_;
+        std::map<std::string, Active> active_;
+        int next_id_ = 1;
+
+        void serve() {
+            while (!stopping_) {
+                dbus_connection_read_write(conn_, 10);
+                while (DBusMessage* msg = dbus_connection_pop_message(conn_)) {
+                    if (dbus_message_get_type(msg) == DBUS_MESSAGE_TYPE_METHOD_CALL) handle(msg);
+                    dbus_message_unref(msg);
+                }
+                emit_due_signals();
+            }
+        }
+
+        void emit_due_signals() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            for (auto& [path, active] : active_) {
+                if (active.signalled || now < active.signal_at) continue;
+                active.signalled = true;
+                if (active.outcome == Outcome::Silent) continue;
+
+                uint32_t reason = active.outcome == Outcome::Activate ? 0 : REASON_NO_SECRETS;
+                active.state = active.outcome == Outcome::Activate ? STATE_ACTIVATED : STATE_DEACTIVATED;
+                DBusMessage* signal = dbus_message_new_signal(path.c_str(), ACTIVE_IFACE, "StateChanged");
+                dbus_message_append_args(signal, DBUS_TYPE_UINT32, &active.state, DBUS_TYPE_UINT32, &reason,
+                                         DBUS_TYPE_INVALID);
+                dbus_connection_send(conn_, signal, nullptr);
+                dbus_message_unref(signal);
+            }
+            dbus_connection_flush(conn_);
+        }
+
+        // Starts an activation; its StateChanged follows a little later, so the
+        // client really has to wait for the signal
+        std::string start_activation(const std::string& connection) {
+            std::string path = ACTIVE_PREFIX + std::to_string(next_id_++);
+            active_[path] = { connection, STATE_ACTIVATING, std::chrono::steady_clock::now() + 100ms, false, outcome_ };
+            return path;
+        }
+
+        void reply_error(DBusMessage* call, const char* name, const char* text) {
+            DBusMessage* reply = dbus_message_new_error(call, name, text);
+            dbus_connection_send(conn_, reply, nullptr);
+            dbus_message_unref(reply);
+        }
+
+        void handle(DBusMessage* call) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string path = dbus_message_get_path(call);
+            std::string member = dbus_message_get_member(call);
+            if (member != "Get") calls_.push_back(member);
+
+            DBusMessage* reply = dbus_message_new_method_return(call);
+            DBusMessageIter out;
+            dbus_message_iter_init_append(reply, &out);
+
+            if (member == "Get") {
+                const char* iface = nullptr;
+                const char* name = nullptr;
+                dbus_message_get_args(call, nullptr, DBUS_TYPE_STRING, &iface, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID);
+                if (!get_property(path, name, &out)) {
+                    dbus_message_unref(reply);
+                    reply_error(call, "org.freedesktop.DBus.Error.UnknownProperty", name);
+                    return;
+                }
+            } else if (member == "GetDevices") {
+                append_paths(&out, { DEVICE_PATH });
+            } else if (member == "ListConnections") {
+                std::vector<std::string> paths;
+                for (const auto& [p, settings] : connections_) paths.push_back(p);
+                append_paths(&out, paths);
+            } else if (member == "GetSettings" || member == "GetSecrets") {
+                auto it = connections_.find(path);
+                if (it == connections_.end()) {
+                    dbus_message_unref(reply);
+                    reply_error(call, "org.freedesktop.NetworkManager.Settings.InvalidConnection", path.c_str());
+                    return;
+                }
+                DBusMessageIter in;
+                dbus_message_iter_init(it->second, &in);
+                copy_value(&in, &out);
+            } else if (member == "AddAndActivateConnection") {
+                std::string connection = SETTINGS_PREFIX + std::to_string(next_id_++);
+                connections_[connection] = dbus_message_ref(call);
+                std::string active = start_activation(connection);
+                const char* c = connection.c_str();
+                const char* a = active.c_str();
+                dbus_message_append_args(reply, DBUS_TYPE_OBJECT_PATH, &c, DBUS_TYPE_OBJECT_PATH, &a, DBUS_TYPE_INVALID);
+            } else if (member == "Update") {
+                auto it = connections_.find(path);
+                if (it != connections_.end()) {
+                    dbus_message_unref(it->second);
+                    it->second = dbus_message_ref(call);
+                }
+            } else if (member == "ActivateConnection") {
+                const char* connection = nullptr;
+                dbus_message_get_args(call, nullptr, DBUS_TYPE_OBJECT_PATH, &connection, DBUS_TYPE_INVALID);
+                std::string active = start_activation(connection);
+                const char* a = active.c_str();
+                dbus_message_append_args(reply, DBUS_TYPE_OBJECT_PATH, &a, DBUS_TYPE_INVALID);
+            } else if (member == "DeactivateConnection") {
+                const char* active = nullptr;
+                dbus_message_get_args(call, nullptr, DBUS_TYPE_OBJECT_PATH, &active, DBUS_TYPE_INVALID);
+                active_.erase(active);
+            } else if (member == "Delete") {
+                auto it = connections_.find(path);
+                if (it != connections_.end()) {
+                    dbus_message_unref(it->second);
+                    connections_.erase(it);
+                }
+            } else {
+                dbus_message_unref(reply);
+                reply_error(call, "org.freedesktop.DBus.Error.UnknownMethod", member.c_str());
+                return;
+            }
+            dbus_connection_send(conn_, reply, nullptr);
+            dbus_message_unref(reply);
+        }
+
+        bool get_property(const std::string& path, const std::string& name, DBusMessageIter* out) {
+            DBusMessageIter variant;
+            if (path == DEVICE_PATH && name == "DeviceType") {
+                uint32_t wifi = 2;
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "u", &variant);
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32, &wifi);
+            } else if (path == DEVICE_PATH && name == "Interface") {
+                const char* iface = "wlan0";
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "s", &variant);
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &iface);
+            } else if (path == DEVICE_PATH && name == "AccessPoints") {
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "ao", &variant);
+                append_paths(&variant, {});
+            } else if (path == NM_PATH && name == "ActiveConnections") {
+                std::vector<std::string> paths;
+                for (const auto& [p, active] : active_) paths.push_back(p);
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "ao", &variant);
+                append_paths(&variant, paths);
+            } else if (active_.count(path) && name == "State") {
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "u", &variant);
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32, &active_[path].state);
+            } else if (active_.count(path) && name == "Id") {
+                auto it = connections_.find(active_[path].connection);
+                std::string id = it == connections_.end() ? "" : settings_id(it->second);
+                const char* text = id.c_str();
+                dbus_message_iter_open_container(out, DBUS_TYPE_VARIANT, "s", &variant);
+                dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &text);
+            } else {
+                return false;
+            }
+            dbus_message_iter_close_container(out, &variant);
+            return true;
+        }
+    };
+
+    NmProfile test_profile(const std::string& password) {
+        NmProfile profile;
+        profile.id = "uniswawifi-students-wlan0";
+        profile.ssid = "uniswawifi-students";
+        profile.interface_name = "wlan0";
+        profile.eap = "peap";
+        profile.phase2_auth = "mschapv2";
+        profile.identity = "2020123456";
+        profile.password = password;
+        return profile;
+    }
+
+    void activation_succeeds(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::Activate);
+        auto res = NmDbus::instance().activate(test_profile("first"), true, 5000);
+        CHECK(res.success);
+        CHECK((nm.take_calls() == std::vector<std::string>{ "GetDevices", "ListConnections", "AddAndActivateConnection" }));
+
+        auto stored = NmDbus::instance().read_profile("uniswawifi-students-wlan0");
+        CHECK(stored.has_value());
+        if (stored) {
+            CHECK(stored->ssid == "uniswawifi-students");
+            CHECK(stored->interface_name == "wlan0");
+            CHECK(stored->eap == "peap");
+            CHECK(stored->identity == "2020123456");
+            CHECK(stored->password == "first");
+        }
+        nm.take_calls();
+    }
+
+    void update_then_activate(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::Activate);
+        auto res = NmDbus::instance().activate(test_profile("second"), true, 5000);
+        CHECK(res.success);
+        CHECK((nm.take_calls() ==
+               std::vector<std::string>{ "GetDevices", "ListConnections", "GetSettings", "Update", "ActivateConnection" }));
+
+        auto stored = NmDbus::instance().read_profile("uniswawifi-students-wlan0");
+        CHECK(stored && stored->password == "second");
+        nm.take_calls();
+
+        // Unchanged: no Update, straight to activation
+        CHECK(NmDbus::instance().activate(test_profile("second"), false, 5000).success);
+        CHECK((nm.take_calls() == std::vector<std::string>{ "GetDevices", "ListConnections", "GetSettings", "ActivateConnection" }));
+    }
+
+    void auth_failure(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::FailNoSecrets);
+        auto res = NmDbus::instance().activate(test_profile("second"), false, 5000);
+        CHECK(!res.success);
+        CHECK(res.message == "Activation failed (reason 9)");
+        nm.take_calls();
+    }
+
+    void timeout(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::Silent);
+        auto started = std::chrono::steady_clock::now();
+        auto res = NmDbus::instance().activate(test_profile("second"), false, 400);
+        auto took = std::chrono::steady_clock::now() - started;
+        CHECK(!res.success);
+        CHECK(res.message == "Timed out waiting for activation");
+        CHECK(took >= 400ms && took < 2s);
+        nm.take_calls();
+    }
+
+    void cancel_cuts_wait_short(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::Silent);
+        CancellationToken token;
+        CancellationScope scope(token);
+        std::thread canceller([token]() mutable {
+            std::this_thread::sleep_for(200ms);
+            token.cancel();
+        });
+        auto started = std::chrono::steady_clock::now();
+        auto res = NmDbus::instance().activate(test_profile("second"), false, 30000);
+        auto took = std::chrono::steady_clock::now() - started;
+        canceller.join();
+        CHECK(res.message == "Cancelled");
+        CHECK(took < 2s);
+        nm.take_calls();
+    }
+
+    void unknown_device(MockNetworkManager& nm) {
+        auto profile = test_profile("second");
+        profile.interface_name = "wlan9";
+        auto res = NmDbus::instance().activate(profile, false, 1000);
+        CHECK(!res.success);
+        CHECK(res.message == "NetworkManager has no WiFi device wlan9");
+        nm.take_calls();
+    }
+
+    void deactivate_and_delete(MockNetworkManager& nm) {
+        nm.set_outcome(MockNetworkManager::Outcome::Activate);
+        CHECK(NmDbus::instance().activate(test_profile("second"), false, 5000).success);
+        nm.take_calls();
+
+        CHECK(NmDbus::instance().deactivate("uniswawifi-students-wlan0"));
+        auto calls = nm.take_calls();
+        CHECK(!calls.empty() && calls.back() == "DeactivateConnection");
+
+        CHECK(NmDbus::instance().delete_connection("uniswawifi-students-wlan0"));
+        calls = nm.take_calls();
+        CHECK(!calls.empty() && calls.back() == "Delete");
+        CHECK(!NmDbus::instance().read_profile("uniswawifi-students-wlan0"));
+        CHECK(!NmDbus::instance().delete_connection("uniswawifi-students-wlan0"));
+    }
+
+}
+
+int main() {
+    const char* session = std::getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (!session) {
+        std::cerr << "No session bus; run under dbus-run-session\n";
+        return 77;
+    }
+    // Before anything touches libdbus: the private bus is our "system" bus
+    setenv("DBUS_SYSTEM_BUS_ADDRESS", session, 1);
+    dbus_threads_init_default();
+
+    CHECK(!NmDbus::instance().available());
+
+    MockNetworkManager nm;
+    if (!nm.start()) {
+        std::cerr << "Cannot own " << NM_SERVICE << " on the test bus\n";
+        return 1;
+    }
+    CHECK(NmDbus::instance().available());
+
+    activation_succeeds(nm);
+    update_then_activate(nm);
+    auth_failure(nm);
+    timeout(nm);
+    cancel_cuts_wait_short(nm);
+    unknown_device(nm);
+    deactivate_and_delete(nm);
+
+    return check_result("NetworkManager D-Bus");
+}
@@ -0,0 +1,109 @@
+/* RetryScheduler and Deadline against a fake Clock: the backoff sequence, the
+ * jitter bounds and where the deadline cuts a run short. No real time passes;
+ * the fake clock only moves when the scheduler sleeps. */
+
+#include "check.h"
+#include "utils/retry_scheduler.h"
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    class FakeClock : public Clock {
+    public:
+        time_point now() override { return now_; }
+        void sleep_for(std::chrono::milliseconds duration) override {
+            sleeps.push_back(duration);
+            now_ += duration;
+        }
+        std::chrono::milliseconds elapsed() const {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(now_ - time_point{});
+        }
+
+        std::vector<std::chrono::milliseconds> sleeps;
+
+    private:
+        time_point now_{};
+    };
+
+    void backoff_sequence() {
+        FakeClock clock;
+        RetryScheduler retry({ 100ms, 1000ms, 2.0, 0.0, 60s }, clock, 1);
+        std::vector<std::chrono::milliseconds> delays;
+        for (int i = 0; i < 6; ++i) delays.push_back(retry.next_delay());
+        CHECK((delays == std::vector<std::chrono::milliseconds>{ 100ms, 200ms, 400ms, 800ms, 1000ms, 1000ms }));
+    }
+
+    void jitter_bounds() {
+        FakeClock clock;
+        RetryScheduler retry({ 1000ms, 1000ms, 1.0, 0.2, 60s }, clock, 42);
+        RetryScheduler same_seed({ 1000ms, 1000ms, 1.0, 0.2, 60s }, clock, 42);
+        bool varied = false;
+        for (int i = 0; i < 1000; ++i) {
+            auto delay = retry.next_delay();
+            CHECK(delay >= 800ms && delay <= 1200ms);
+            CHECK(delay == same_seed.next_delay());
+            varied = varied || delay != 1000ms;
+        }
+        CHECK(varied);
+    }
+
+    void deadline_cuts_run_short() {
+        // Tries at 0, 100, 300 and 700 ms; the last sleep is cut to the 300 ms
+        // left, and the final try runs at the deadline itself
+        FakeClock clock;
+        RetryScheduler retry({ 100ms, 400ms, 2.0, 0.0, 1000ms }, clock, 1);
+        bool ok = retry.run([] { return false; });
+        CHECK(!ok);
+        CHECK(retry.attempts() == 5);
+        CHECK((clock.sleeps == std::vector<std::chrono::milliseconds>{ 100ms, 200ms, 400ms, 300ms }));
+        CHECK(clock.elapsed() == 1000ms);
+        CHECK(retry.expired());
+    }
+
+    void success_stops_run() {
+        FakeClock clock;
+        RetryScheduler retry({ 100ms, 400ms, 2.0, 0.0, 1000ms }, clock, 1);
+        int calls = 0;
+        CHECK(retry.run([&calls] { return ++calls == 3; }));
+        CHECK(retry.attempts() == 3);
+        CHECK(clock.elapsed() == 300ms);
+    }
+
+    void outer_deadline_bounds_pause() {
+        FakeClock clock;
+        Deadline outer(250ms, clock);
+        RetryScheduler retry({ 200ms, 200ms, 1.0, 0.0, 10s }, clock, 1, &outer);
+        CHECK(retry.pause());
+        CHECK(retry.pause());
+        CHECK(!retry.pause());
+        CHECK((clock.sleeps == std::vector<std::chrono::milliseconds>{ 200ms, 50ms }));
+    }
+
+    void deadline_rounding() {
+        FakeClock clock;
+        Deadline deadline(1500ms, clock);
+        CHECK(deadline.remaining_seconds() == 2);
+        CHECK(deadline.capped(1000ms) == 1000ms);
+        clock.sleep_for(1499ms);
+        CHECK(deadline.remaining() == 1ms);
+        CHECK(deadline.remaining_seconds() == 1);
+        clock.sleep_for(5ms);
+        CHECK(deadline.expired());
+        CHECK(deadline.remaining() == 0ms);
+        CHECK(deadline.remaining_seconds() == 1);
+    }
+
+}
+
+int main() {
+    backoff_sequence();
+    jitter_bounds();
+    deadline_cuts_run_short();
+    success_stops_run();
+    outer_deadline_bounds_pause();
+    deadline_rounding();
+
+    return check_result("retry scheduler");
+}